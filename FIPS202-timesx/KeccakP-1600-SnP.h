@@ -31,6 +31,7 @@ Please refer to SnP-documentation.h for more details.
 #define KeccakP1600_12rounds_FastLoop_supported
 
 #include <stddef.h>
+#include <stdint.h>
 
 #define KeccakP1600_StaticInitialize()
 void KeccakP1600_Initialize(void *state);
@@ -48,6 +49,10 @@ void KeccakP1600_Permute_12rounds(void *state);
 void KeccakP1600_Permute_24rounds(void *state);
 void KeccakP1600_ExtractBytes(const void *state, unsigned char *data, unsigned int offset, unsigned int length);
 void KeccakP1600_ExtractAndAddBytes(const void *state, const unsigned char *input, unsigned char *output, unsigned int offset, unsigned int length);
+void KeccakP1600_SqueezeBlocks(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t blockCount);
+void KeccakP1600_12rounds_SqueezeBlocks(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t blockCount);
+void KeccakP1600_SqueezeBlocksInterleaved(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t blockCount);
+void KeccakP1600_12rounds_SqueezeBlocksInterleaved(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t blockCount);
 size_t KeccakF1600_FastLoop_Absorb(void *state, unsigned int laneCount, const unsigned char *data, size_t dataByteLen);
 size_t KeccakP1600_12rounds_FastLoop_Absorb(void *state, unsigned int laneCount, const unsigned char *data, size_t dataByteLen);
 
@@ -369,6 +369,101 @@ void KeccakP1600_Permute_12rounds(void *state)
 
 /* ---------------------------------------------------------------- */
 
+/* With interleaved set, the blocks are stored in groups of 8 blocks, lane by lane: lane x of block 8*g + i
+ * (counted from firstBlock) at data + (g*laneCount + x)*64 + i*8. */
+static void KeccakP1600_SqueezeBlocksNrounds(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t blockCount, unsigned int nrounds, int interleaved)
+{
+    declareABCDE
+    #ifndef KeccakP1600_fullUnrolling
+    unsigned int i;
+    #endif
+    const uint64_t *stateAsLanes = (const uint64_t*)state;
+    uint64_t lanesIn[25];
+    uint64_t lanesOut[21];
+    uint64_t columnParities[5];
+    uint64_t counterLaneTemplate;
+    unsigned int counterColumn = counterLane%5;
+    unsigned int x, lanePosition;
+    unsigned int blockInGroup = 0;
+
+    /* Theta of the first round only depends on the counter through the parity of its column:
+     * apply it to the template once, and only give the parity of the counter to the rounds. */
+    for(x=0; x<5; x++)
+        columnParities[x] = stateAsLanes[x] ^ stateAsLanes[x+5] ^ stateAsLanes[x+10] ^ stateAsLanes[x+15] ^ stateAsLanes[x+20];
+    for(lanePosition=0; lanePosition<25; lanePosition++) {
+        x = lanePosition%5;
+        lanesIn[lanePosition] = stateAsLanes[lanePosition] ^ columnParities[(x+4)%5] ^ ROL64(columnParities[(x+1)%5], 1);
+    }
+    for(x=0; x<5; x++)
+        columnParities[x] = 0;
+    counterLaneTemplate = lanesIn[counterLane];
+    while(blockCount--) {
+        lanesIn[counterLane] = counterLaneTemplate ^ firstBlock;
+        columnParities[counterColumn] = firstBlock++;
+        copyFromState(A, lanesIn)
+        Ca = columnParities[0];
+        Ce = columnParities[1];
+        Ci = columnParities[2];
+        Co = columnParities[3];
+        Cu = columnParities[4];
+        if (nrounds == 12) {
+            squeezeRounds12
+        }
+        else {
+            squeezeRounds24
+        }
+        copyRateToState(lanesOut, A)
+#ifdef KeccakP1600_useLaneComplementing
+        lanesOut[ 1] = ~lanesOut[ 1];
+        lanesOut[ 2] = ~lanesOut[ 2];
+        lanesOut[ 8] = ~lanesOut[ 8];
+        lanesOut[12] = ~lanesOut[12];
+        lanesOut[17] = ~lanesOut[17];
+        lanesOut[20] = ~lanesOut[20];
+#endif
+#if (PLATFORM_BYTE_ORDER != IS_LITTLE_ENDIAN)
+        for(lanePosition=0; lanePosition<laneCount; lanePosition++) {
+            uint64_t lane = lanesOut[lanePosition];
+            for(x=0; x<8; x++)
+                ((uint8_t*)&lanesOut[lanePosition])[x] = (uint8_t)(lane >> (8*x));
+        }
+#endif
+        if (interleaved) {
+            for(lanePosition=0; lanePosition<laneCount; lanePosition++)
+                memcpy(data + lanePosition*64 + blockInGroup*8, &lanesOut[lanePosition], 8);
+            blockInGroup = (blockInGroup + 1)%8;
+            if (!blockInGroup)
+                data += 8*laneCount*8;
+        }
+        else {
+            memcpy(data, lanesOut, laneCount*8);
+            data += laneCount*8;
+        }
+    }
+}
+
+void KeccakP1600_SqueezeBlocks(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t blockCount)
+{
+    KeccakP1600_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, blockCount, 24, 0);
+}
+
+void KeccakP1600_12rounds_SqueezeBlocks(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t blockCount)
+{
+    KeccakP1600_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, blockCount, 12, 0);
+}
+
+void KeccakP1600_SqueezeBlocksInterleaved(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t blockCount)
+{
+    KeccakP1600_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, blockCount, 24, 1);
+}
+
+void KeccakP1600_12rounds_SqueezeBlocksInterleaved(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t blockCount)
+{
+    KeccakP1600_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, blockCount, 12, 1);
+}
+
+/* ---------------------------------------------------------------- */
+
 void KeccakP1600_ExtractBytesInLane(const void *state, unsigned int lanePosition, unsigned char *data, unsigned int offset, unsigned int length)
 {
     uint64_t lane = ((uint64_t*)state)[lanePosition];
@@ -19,6 +19,13 @@ This implementation comes with KeccakP-1600-times4-SnP.h in the same folder.
 Please refer to LowLevel.build for the exact list of other files it must be combined with.
 */
 
+/* Always compiled for AVX2, the implementation is selected at runtime (see vexof.c) */
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx2")
+#endif
+
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -692,6 +699,94 @@ void KeccakP1600times4_ExtractAndAddLanesAll(const void *states, const unsigned
     E##su = XOR256(Bsu, ANDnu256(Bsa, Bse)); \
 \
 
+/* --- Theta Rho Pi Chi Iota, only computing the first 21 lanes (for SqueezeBlocks) */
+/* --- 64-bit lanes mapped to 64-bit words */
+#define thetaRhoPiChiIotaRate(i, A, E) \
+    ROL64in256(Ce1, Ce, 1); \
+    Da = XOR256(Cu, Ce1); \
+    ROL64in256(Ci1, Ci, 1); \
+    De = XOR256(Ca, Ci1); \
+    ROL64in256(Co1, Co, 1); \
+    Di = XOR256(Ce, Co1); \
+    ROL64in256(Cu1, Cu, 1); \
+    Do = XOR256(Ci, Cu1); \
+    ROL64in256(Ca1, Ca, 1); \
+    Du = XOR256(Co, Ca1); \
+\
+    XOReq256(A##ba, Da); \
+    Bba = A##ba; \
+    XOReq256(A##ge, De); \
+    ROL64in256(Bbe, A##ge, 44); \
+    XOReq256(A##ki, Di); \
+    ROL64in256(Bbi, A##ki, 43); \
+    E##ba = XOR256(Bba, ANDnu256(Bbe, Bbi)); \
+    XOReq256(E##ba, CONST256_64(KeccakF1600RoundConstants[i])); \
+    XOReq256(A##mo, Do); \
+    ROL64in256(Bbo, A##mo, 21); \
+    E##be = XOR256(Bbe, ANDnu256(Bbi, Bbo)); \
+    XOReq256(A##su, Du); \
+    ROL64in256(Bbu, A##su, 14); \
+    E##bi = XOR256(Bbi, ANDnu256(Bbo, Bbu)); \
+    E##bo = XOR256(Bbo, ANDnu256(Bbu, Bba)); \
+    E##bu = XOR256(Bbu, ANDnu256(Bba, Bbe)); \
+\
+    XOReq256(A##bo, Do); \
+    ROL64in256(Bga, A##bo, 28); \
+    XOReq256(A##gu, Du); \
+    ROL64in256(Bge, A##gu, 20); \
+    XOReq256(A##ka, Da); \
+    ROL64in256(Bgi, A##ka, 3); \
+    E##ga = XOR256(Bga, ANDnu256(Bge, Bgi)); \
+    XOReq256(A##me, De); \
+    ROL64in256(Bgo, A##me, 45); \
+    E##ge = XOR256(Bge, ANDnu256(Bgi, Bgo)); \
+    XOReq256(A##si, Di); \
+    ROL64in256(Bgu, A##si, 61); \
+    E##gi = XOR256(Bgi, ANDnu256(Bgo, Bgu)); \
+    E##go = XOR256(Bgo, ANDnu256(Bgu, Bga)); \
+    E##gu = XOR256(Bgu, ANDnu256(Bga, Bge)); \
+\
+    XOReq256(A##be, De); \
+    ROL64in256(Bka, A##be, 1); \
+    XOReq256(A##gi, Di); \
+    ROL64in256(Bke, A##gi, 6); \
+    XOReq256(A##ko, Do); \
+    ROL64in256(Bki, A##ko, 25); \
+    E##ka = XOR256(Bka, ANDnu256(Bke, Bki)); \
+    XOReq256(A##mu, Du); \
+    ROL64in256_8(Bko, A##mu); \
+    E##ke = XOR256(Bke, ANDnu256(Bki, Bko)); \
+    XOReq256(A##sa, Da); \
+    ROL64in256(Bku, A##sa, 18); \
+    E##ki = XOR256(Bki, ANDnu256(Bko, Bku)); \
+    E##ko = XOR256(Bko, ANDnu256(Bku, Bka)); \
+    E##ku = XOR256(Bku, ANDnu256(Bka, Bke)); \
+\
+    XOReq256(A##bu, Du); \
+    ROL64in256(Bma, A##bu, 27); \
+    XOReq256(A##ga, Da); \
+    ROL64in256(Bme, A##ga, 36); \
+    XOReq256(A##ke, De); \
+    ROL64in256(Bmi, A##ke, 10); \
+    E##ma = XOR256(Bma, ANDnu256(Bme, Bmi)); \
+    XOReq256(A##mi, Di); \
+    ROL64in256(Bmo, A##mi, 15); \
+    E##me = XOR256(Bme, ANDnu256(Bmi, Bmo)); \
+    XOReq256(A##so, Do); \
+    ROL64in256_56(Bmu, A##so); \
+    E##mi = XOR256(Bmi, ANDnu256(Bmo, Bmu)); \
+    E##mo = XOR256(Bmo, ANDnu256(Bmu, Bma)); \
+    E##mu = XOR256(Bmu, ANDnu256(Bma, Bme)); \
+\
+    XOReq256(A##bi, Di); \
+    ROL64in256(Bsa, A##bi, 62); \
+    XOReq256(A##go, Do); \
+    ROL64in256(Bse, A##go, 55); \
+    XOReq256(A##ku, Du); \
+    ROL64in256(Bsi, A##ku, 39); \
+    E##sa = XOR256(Bsa, ANDnu256(Bse, Bsi)); \
+\
+
 static ALIGN(KeccakP1600times4_statesAlignment) const uint64_t KeccakF1600RoundConstants[24] = {
     0x0000000000000001ULL,
     0x0000000000008082ULL,
@@ -772,6 +867,30 @@ static ALIGN(KeccakP1600times4_statesAlignment) const uint64_t KeccakF1600RoundC
     STORE256(state[23], X##so); \
     STORE256(state[24], X##su); \
 
+/* Only the lanes that SqueezeBlocks extracts, at most 21 */
+#define copyRateToState(state, X) \
+    STORE256(state[ 0], X##ba); \
+    STORE256(state[ 1], X##be); \
+    STORE256(state[ 2], X##bi); \
+    STORE256(state[ 3], X##bo); \
+    STORE256(state[ 4], X##bu); \
+    STORE256(state[ 5], X##ga); \
+    STORE256(state[ 6], X##ge); \
+    STORE256(state[ 7], X##gi); \
+    STORE256(state[ 8], X##go); \
+    STORE256(state[ 9], X##gu); \
+    STORE256(state[10], X##ka); \
+    STORE256(state[11], X##ke); \
+    STORE256(state[12], X##ki); \
+    STORE256(state[13], X##ko); \
+    STORE256(state[14], X##ku); \
+    STORE256(state[15], X##ma); \
+    STORE256(state[16], X##me); \
+    STORE256(state[17], X##mi); \
+    STORE256(state[18], X##mo); \
+    STORE256(state[19], X##mu); \
+    STORE256(state[20], X##sa);
+
 #define copyStateVariables(X, Y) \
     X##ba = Y##ba; \
     X##be = Y##be; \
@@ -858,6 +977,122 @@ void KeccakP1600times4_PermuteAll_4rounds(void *states)
     copyToState(statesAsLanes, A)
 }
 
+static void KeccakP1600times4_StoreTransposed(unsigned char *data, unsigned int rowLengthInBytes, unsigned int laneCount, const V256 *lanes)
+{
+    V256 lanesL01, lanesH01, lanesL23, lanesH23;
+    V256 lanes0, lanes1, lanes2, lanes3;
+
+    lanesL01 = UNPACKL( lanes[0], lanes[1] );
+    lanesH01 = UNPACKH( lanes[0], lanes[1] );
+    lanesL23 = UNPACKL( lanes[2], lanes[3] );
+    lanesH23 = UNPACKH( lanes[2], lanes[3] );
+    lanes0 = PERM128( lanesL01, lanesL23, 0x20 );
+    lanes1 = PERM128( lanesH01, lanesH23, 0x20 );
+    lanes2 = PERM128( lanesL01, lanesL23, 0x31 );
+    lanes3 = PERM128( lanesH01, lanesH23, 0x31 );
+    if (laneCount >= 4) {
+        STORE256u(data[0*rowLengthInBytes], lanes0);
+        STORE256u(data[1*rowLengthInBytes], lanes1);
+        STORE256u(data[2*rowLengthInBytes], lanes2);
+        STORE256u(data[3*rowLengthInBytes], lanes3);
+    }
+    else {
+        V256 mask = _mm256_cmpgt_epi64(_mm256_set1_epi64x(laneCount), _mm256_set_epi64x(3, 2, 1, 0));
+        _mm256_maskstore_epi64((long long *)(data + 0*rowLengthInBytes), mask, lanes0);
+        _mm256_maskstore_epi64((long long *)(data + 1*rowLengthInBytes), mask, lanes1);
+        _mm256_maskstore_epi64((long long *)(data + 2*rowLengthInBytes), mask, lanes2);
+        _mm256_maskstore_epi64((long long *)(data + 3*rowLengthInBytes), mask, lanes3);
+    }
+}
+
+/* With interleaved set, the blocks are stored in groups of 8 blocks, lane by lane: lane x of block 8*g + i
+ * (counted from firstBlock) at data + (g*laneCount + x)*64 + i*8. A batch fills half of a group. */
+static void KeccakP1600times4_SqueezeBlocksNrounds(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount, unsigned int nrounds, int interleaved)
+{
+    const uint64_t *templateAsLanes = (const uint64_t*)state;
+    ALIGN(KeccakP1600times4_statesAlignment) V256 lanesIn[25];
+    ALIGN(KeccakP1600times4_statesAlignment) V256 lanesOut[28];
+    unsigned int rowLengthInBytes = laneCount*SnP_laneLengthInBytes;
+    unsigned int lanePosition;
+    unsigned int counterColumn = counterLane%5;
+    unsigned int x;
+    unsigned int half = 0;
+    V256 counterLaneTemplate, counters, columnParities[5];
+    declareABCDE
+    #ifndef KeccakP1600times4_fullUnrolling
+    unsigned int i;
+    #endif
+
+    for(lanePosition=0; lanePosition<25; lanePosition++)
+        lanesIn[lanePosition] = CONST256_64(templateAsLanes[lanePosition]);
+    /* Theta of the first round only depends on the counters through the parity of their column:
+     * apply it to the template once, and only give the parities of the counters to the rounds. */
+    for(x=0; x<5; x++)
+        columnParities[x] = XOR256(lanesIn[x], XOR256(lanesIn[x+5], XOR256(lanesIn[x+10], XOR256(lanesIn[x+15], lanesIn[x+20]))));
+    for(lanePosition=0; lanePosition<25; lanePosition++) {
+        x = lanePosition%5;
+        ROL64in256(Da, columnParities[(x+1)%5], 1);
+        XOReq256(lanesIn[lanePosition], XOR256(columnParities[(x+4)%5], Da));
+    }
+    for(x=0; x<5; x++)
+        columnParities[x] = _mm256_setzero_si256();
+    counterLaneTemplate = lanesIn[counterLane];
+    for(lanePosition=21; lanePosition<28; lanePosition++)
+        lanesOut[lanePosition] = _mm256_setzero_si256();
+    counters = _mm256_add_epi64(CONST256_64(firstBlock), LOAD4_64(3, 2, 1, 0));
+
+    while(batchCount-- > 0) {
+        lanesIn[counterLane] = XOR256(counterLaneTemplate, counters);
+        columnParities[counterColumn] = counters;
+        copyFromState(A, lanesIn)
+        Ca = columnParities[0];
+        Ce = columnParities[1];
+        Ci = columnParities[2];
+        Co = columnParities[3];
+        Cu = columnParities[4];
+        if (nrounds == 12) {
+            squeezeRounds12
+        }
+        else {
+            squeezeRounds24
+        }
+        copyRateToState(lanesOut, A)
+        if (interleaved) {
+            for(lanePosition=0; lanePosition<laneCount; lanePosition++)
+                _mm256_storeu_si256((V256*)(data + lanePosition*64 + half*32), lanesOut[lanePosition]);
+            half ^= 1;
+            if (!half)
+                data += 8*rowLengthInBytes;
+        }
+        else {
+            for(lanePosition=0; lanePosition<laneCount; lanePosition+=4)
+                KeccakP1600times4_StoreTransposed(data + lanePosition*SnP_laneLengthInBytes, rowLengthInBytes, laneCount - lanePosition, lanesOut + lanePosition);
+            data += 4*rowLengthInBytes;
+        }
+        counters = _mm256_add_epi64(counters, CONST256_64(4));
+    }
+}
+
+void KeccakP1600times4_SqueezeBlocks(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount)
+{
+    KeccakP1600times4_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, batchCount, 24, 0);
+}
+
+void KeccakP1600times4_12rounds_SqueezeBlocks(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount)
+{
+    KeccakP1600times4_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, batchCount, 12, 0);
+}
+
+void KeccakP1600times4_SqueezeBlocksInterleaved(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount)
+{
+    KeccakP1600times4_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, batchCount, 24, 1);
+}
+
+void KeccakP1600times4_12rounds_SqueezeBlocksInterleaved(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount)
+{
+    KeccakP1600times4_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, batchCount, 12, 1);
+}
+
 size_t KeccakF1600times4_FastLoop_Absorb(void *states, unsigned int laneCount, unsigned int laneOffsetParallel, unsigned int laneOffsetSerial, const unsigned char *data, size_t dataByteLen)
 {
     if (laneCount == 21) {
@@ -1319,3 +1554,7 @@ size_t KeccakP1600times4_KravatteExpand(uint64_t *yAccu, const uint64_t *kRoll,
 #undef Kravatte_Roll
 #undef UNINTLEAVEa
 #undef INTLEAVEa
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
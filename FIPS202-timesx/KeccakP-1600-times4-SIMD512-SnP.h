@@ -0,0 +1,45 @@
+/*
+The Keccak-p permutations, designed by Guido Bertoni, Joan Daemen, Michaël Peeters and Gilles Van Assche.
+
+To the extent possible under law, the implementer has waived all copyright
+and related or neighboring rights to the source code in this file.
+http://creativecommons.org/publicdomain/zero/1.0/
+
+---
+
+Interface of the AVX-512 implementation of Keccak-p[1600]×4 in KeccakP-1600-times4-SIMD512.c.
+It is the interface of KeccakP-1600-times4-SnP.h with the KeccakP1600times4x512 prefix, so that
+it can be linked together with the AVX2 implementation and selected at runtime.
+*/
+
+#ifndef _KeccakP_1600_times4x512_SnP_h_
+#define _KeccakP_1600_times4x512_SnP_h_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define KeccakP1600times4x512_statesSizeInBytes     800
+#define KeccakP1600times4x512_statesAlignment       32
+
+void KeccakP1600times4x512_InitializeAll(void *states);
+void KeccakP1600times4x512_AddBytes(void *states, unsigned int instanceIndex, const unsigned char *data, unsigned int offset, unsigned int length);
+void KeccakP1600times4x512_AddLanesAll(void *states, const unsigned char *data, unsigned int laneCount, unsigned int laneOffset);
+void KeccakP1600times4x512_OverwriteBytes(void *states, unsigned int instanceIndex, const unsigned char *data, unsigned int offset, unsigned int length);
+void KeccakP1600times4x512_OverwriteLanesAll(void *states, const unsigned char *data, unsigned int laneCount, unsigned int laneOffset);
+void KeccakP1600times4x512_OverwriteWithZeroes(void *states, unsigned int instanceIndex, unsigned int byteCount);
+void KeccakP1600times4x512_PermuteAll_4rounds(void *states);
+void KeccakP1600times4x512_PermuteAll_6rounds(void *states);
+void KeccakP1600times4x512_PermuteAll_12rounds(void *states);
+void KeccakP1600times4x512_PermuteAll_24rounds(void *states);
+void KeccakP1600times4x512_ExtractBytes(const void *states, unsigned int instanceIndex, unsigned char *data, unsigned int offset, unsigned int length);
+void KeccakP1600times4x512_ExtractLanesAll(const void *states, unsigned char *data, unsigned int laneCount, unsigned int laneOffset);
+void KeccakP1600times4x512_ExtractAndAddBytes(const void *states, unsigned int instanceIndex,  const unsigned char *input, unsigned char *output, unsigned int offset, unsigned int length);
+void KeccakP1600times4x512_ExtractAndAddLanesAll(const void *states, const unsigned char *input, unsigned char *output, unsigned int laneCount, unsigned int laneOffset);
+void KeccakP1600times4x512_SqueezeBlocks(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount);
+void KeccakP1600times4x512_12rounds_SqueezeBlocks(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount);
+void KeccakP1600times4x512_SqueezeBlocksInterleaved(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount);
+void KeccakP1600times4x512_12rounds_SqueezeBlocksInterleaved(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount);
+size_t KeccakF1600times4x512_FastLoop_Absorb(void *states, unsigned int laneCount, unsigned int laneOffsetParallel, unsigned int laneOffsetSerial, const unsigned char *data, size_t dataByteLen);
+size_t KeccakP1600times4x512_12rounds_FastLoop_Absorb(void *states, unsigned int laneCount, unsigned int laneOffsetParallel, unsigned int laneOffsetSerial, const unsigned char *data, size_t dataByteLen);
+
+#endif
@@ -19,6 +19,13 @@ This implementation comes with KeccakP-1600-times4-SnP.h in the same folder.
 Please refer to LowLevel.build for the exact list of other files it must be combined with.
 */
 
+/* Always compiled for AVX-512, the implementation is selected at runtime (see vexof.c) */
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f,avx512vl"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx512f,avx512vl")
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,6 +35,28 @@ Please refer to LowLevel.build for the exact list of other files it must be comb
 #include <immintrin.h>
 #include <emmintrin.h>
 #include "align.h"
+
+/* Give the functions of KeccakP-1600-times4-SnP.h the names of KeccakP-1600-times4-SIMD512-SnP.h */
+#define KeccakP1600times4_InitializeAll KeccakP1600times4x512_InitializeAll
+#define KeccakP1600times4_AddBytes KeccakP1600times4x512_AddBytes
+#define KeccakP1600times4_AddLanesAll KeccakP1600times4x512_AddLanesAll
+#define KeccakP1600times4_OverwriteBytes KeccakP1600times4x512_OverwriteBytes
+#define KeccakP1600times4_OverwriteLanesAll KeccakP1600times4x512_OverwriteLanesAll
+#define KeccakP1600times4_OverwriteWithZeroes KeccakP1600times4x512_OverwriteWithZeroes
+#define KeccakP1600times4_ExtractBytes KeccakP1600times4x512_ExtractBytes
+#define KeccakP1600times4_ExtractLanesAll KeccakP1600times4x512_ExtractLanesAll
+#define KeccakP1600times4_ExtractAndAddBytes KeccakP1600times4x512_ExtractAndAddBytes
+#define KeccakP1600times4_ExtractAndAddLanesAll KeccakP1600times4x512_ExtractAndAddLanesAll
+#define KeccakP1600times4_PermuteAll_24rounds KeccakP1600times4x512_PermuteAll_24rounds
+#define KeccakP1600times4_PermuteAll_12rounds KeccakP1600times4x512_PermuteAll_12rounds
+#define KeccakP1600times4_PermuteAll_6rounds KeccakP1600times4x512_PermuteAll_6rounds
+#define KeccakP1600times4_PermuteAll_4rounds KeccakP1600times4x512_PermuteAll_4rounds
+#define KeccakP1600times4_SqueezeBlocks KeccakP1600times4x512_SqueezeBlocks
+#define KeccakP1600times4_12rounds_SqueezeBlocks KeccakP1600times4x512_12rounds_SqueezeBlocks
+#define KeccakP1600times4_SqueezeBlocksInterleaved KeccakP1600times4x512_SqueezeBlocksInterleaved
+#define KeccakP1600times4_12rounds_SqueezeBlocksInterleaved KeccakP1600times4x512_12rounds_SqueezeBlocksInterleaved
+#define KeccakF1600times4_FastLoop_Absorb KeccakF1600times4x512_FastLoop_Absorb
+#define KeccakP1600times4_12rounds_FastLoop_Absorb KeccakP1600times4x512_12rounds_FastLoop_Absorb
 #include "KeccakP-1600-times4-SnP.h"
 #include "SIMD512-4-config.h"
 
@@ -547,7 +576,25 @@ static ALIGN(KeccakP1600times4_statesAlignment) const uint64_t KeccakP1600RoundC
     KeccakP_ThetaRhoPiChi( _L1, _L2, _L3, _L4, _L5, _Bo, _Bu, _Ba, _Be, _Bi, 41,  2, 62, 55, 39 )
 
 #define KeccakP_4rounds( i ) \
-    KeccakP_ThetaRhoPiChiIota0(_ba, _ge, _ki, _mo, _su, CONST256_64(KeccakP1600RoundConstants[i]) ); \
+    KeccakP_4roundsCustom( i, KeccakP_ThetaRhoPiChiIota0, KeccakP_ThetaRhoPiChi4 )
+
+/* First round of SqueezeBlocks: theta was applied to the template in advance, and _Da, ..., _Du only hold the effect of the counters */
+#define KeccakP_RhoPiChiIota0( _L1, _L2, _L3, _L4, _L5, _rc ) \
+    KeccakP_ThetaRhoPiChi( _L1, _L2, _L3, _L4, _L5, _Ba, _Be, _Bi, _Bo, _Bu,  0, 44, 43, 21, 14 ); \
+    _L1 = XOR(_L1, _rc) /* Iota */
+
+/* Last row of the last round of SqueezeBlocks: only _sa is in the rate (of at most 21 lanes) */
+#define KeccakP_ThetaRhoPiChi4Rate( _L1, _L2, _L3, _L4, _L5 ) \
+    _Ba = XOR(_L3, _Di); \
+    _Be = XOR(_L4, _Do); \
+    _Bi = XOR(_L5, _Du); \
+    _Ba = ROL(_Ba, 62); \
+    _Be = ROL(_Be, 55); \
+    _Bi = ROL(_Bi, 39); \
+    _L1 = Chi( _Ba, _Be, _Bi)
+
+#define KeccakP_4roundsCustom( i, _Round0, _LastRow ) \
+    _Round0(_ba, _ge, _ki, _mo, _su, CONST256_64(KeccakP1600RoundConstants[i]) ); \
     KeccakP_ThetaRhoPiChi1(    _ka, _me, _si, _bo, _gu ); \
     KeccakP_ThetaRhoPiChi2(    _sa, _be, _gi, _ko, _mu ); \
     KeccakP_ThetaRhoPiChi3(    _ga, _ke, _mi, _so, _bu ); \
@@ -569,7 +616,7 @@ static ALIGN(KeccakP1600times4_statesAlignment) const uint64_t KeccakP1600RoundC
     KeccakP_ThetaRhoPiChi1(    _ga, _ge, _gi, _go, _gu ); \
     KeccakP_ThetaRhoPiChi2(    _ka, _ke, _ki, _ko, _ku ); \
     KeccakP_ThetaRhoPiChi3(    _ma, _me, _mi, _mo, _mu ); \
-    KeccakP_ThetaRhoPiChi4(    _sa, _se, _si, _so, _su )
+    _LastRow(                  _sa, _se, _si, _so, _su )
 
 #define KeccakP_2rounds( i ) \
     KeccakP_ThetaRhoPiChiIota0(_ba, _ke, _si, _go, _mu, CONST256_64(KeccakP1600RoundConstants[i]) ); \
@@ -632,6 +679,19 @@ static ALIGN(KeccakP1600times4_statesAlignment) const uint64_t KeccakP1600RoundC
 #error "Unrolling is not correctly specified!"
 #endif
 
+#define squeezeRounds12 \
+    KeccakP_4roundsCustom( 12, KeccakP_RhoPiChiIota0, KeccakP_ThetaRhoPiChi4 ); \
+    KeccakP_4rounds( 16 ); \
+    KeccakP_4roundsCustom( 20, KeccakP_ThetaRhoPiChiIota0, KeccakP_ThetaRhoPiChi4Rate )
+
+#define squeezeRounds24 \
+    KeccakP_4roundsCustom( 0, KeccakP_RhoPiChiIota0, KeccakP_ThetaRhoPiChi4 ); \
+    KeccakP_4rounds( 4 ); \
+    KeccakP_4rounds( 8 ); \
+    KeccakP_4rounds( 12 ); \
+    KeccakP_4rounds( 16 ); \
+    KeccakP_4roundsCustom( 20, KeccakP_ThetaRhoPiChiIota0, KeccakP_ThetaRhoPiChi4Rate )
+
 #define copyFromState2rounds(pState) \
     _ba = pState[ 0]; \
     _be = pState[16]; /* me */ \
@@ -713,6 +773,30 @@ static ALIGN(KeccakP1600times4_statesAlignment) const uint64_t KeccakP1600RoundC
     pState[23] = _so; \
     pState[24] = _su
 
+/* Only the lanes that SqueezeBlocks extracts, at most 21 */
+#define copyRateToState(pState) \
+    pState[ 0] = _ba; \
+    pState[ 1] = _be; \
+    pState[ 2] = _bi; \
+    pState[ 3] = _bo; \
+    pState[ 4] = _bu; \
+    pState[ 5] = _ga; \
+    pState[ 6] = _ge; \
+    pState[ 7] = _gi; \
+    pState[ 8] = _go; \
+    pState[ 9] = _gu; \
+    pState[10] = _ka; \
+    pState[11] = _ke; \
+    pState[12] = _ki; \
+    pState[13] = _ko; \
+    pState[14] = _ku; \
+    pState[15] = _ma; \
+    pState[16] = _me; \
+    pState[17] = _mi; \
+    pState[18] = _mo; \
+    pState[19] = _mu; \
+    pState[20] = _sa
+
 void KeccakP1600times4_PermuteAll_24rounds(void *states)
 {
     V256 *statesAsLanes = (V256*)states;
@@ -760,6 +844,119 @@ void KeccakP1600times4_PermuteAll_4rounds(void *states)
     copyToState(statesAsLanes);
 }
 
+static void KeccakP1600times4_StoreTransposed(unsigned char *data, unsigned int rowLengthInBytes, unsigned int laneCount, const V256 *lanes)
+{
+    V256 t0, t1, t2, t3;
+    V256 r0, r1, r2, r3;
+
+    t0 = _mm256_unpacklo_epi64(lanes[0], lanes[1]);
+    t1 = _mm256_unpackhi_epi64(lanes[0], lanes[1]);
+    t2 = _mm256_unpacklo_epi64(lanes[2], lanes[3]);
+    t3 = _mm256_unpackhi_epi64(lanes[2], lanes[3]);
+    r0 = _mm256_permute2x128_si256(t0, t2, 0x20);
+    r1 = _mm256_permute2x128_si256(t1, t3, 0x20);
+    r2 = _mm256_permute2x128_si256(t0, t2, 0x31);
+    r3 = _mm256_permute2x128_si256(t1, t3, 0x31);
+    if (laneCount >= 4) {
+        _mm256_storeu_si256((V256*)(data + 0*rowLengthInBytes), r0);
+        _mm256_storeu_si256((V256*)(data + 1*rowLengthInBytes), r1);
+        _mm256_storeu_si256((V256*)(data + 2*rowLengthInBytes), r2);
+        _mm256_storeu_si256((V256*)(data + 3*rowLengthInBytes), r3);
+    }
+    else {
+        __mmask8 mask = (__mmask8)((1 << laneCount) - 1);
+        _mm256_mask_storeu_epi64(data + 0*rowLengthInBytes, mask, r0);
+        _mm256_mask_storeu_epi64(data + 1*rowLengthInBytes, mask, r1);
+        _mm256_mask_storeu_epi64(data + 2*rowLengthInBytes, mask, r2);
+        _mm256_mask_storeu_epi64(data + 3*rowLengthInBytes, mask, r3);
+    }
+}
+
+/* With interleaved set, the blocks are stored in groups of 8 blocks, lane by lane: lane x of block 8*g + i
+ * (counted from firstBlock) at data + (g*laneCount + x)*64 + i*8. A batch fills half of a group. */
+static void KeccakP1600times4_SqueezeBlocksNrounds(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount, unsigned int nrounds, int interleaved)
+{
+    const uint64_t *templateAsLanes = (const uint64_t*)state;
+    ALIGN(KeccakP1600times4_statesAlignment) V256 lanesIn[25];
+    ALIGN(KeccakP1600times4_statesAlignment) V256 lanesOut[28];
+    unsigned int rowLengthInBytes = laneCount*SnP_laneLengthInBytes;
+    unsigned int lanePosition;
+    unsigned int counterColumn = counterLane%5;
+    unsigned int x;
+    unsigned int half = 0;
+    V256 counterLaneTemplate, counters, thetaEffects[5];
+    KeccakP_DeclareVars;
+
+    for(lanePosition=0; lanePosition<25; lanePosition++)
+        lanesIn[lanePosition] = CONST256_64(templateAsLanes[lanePosition]);
+    /* Theta of the first round only depends on the counters through the parity of their column:
+     * apply it to the template once, and add the effect of the counters per batch. */
+    for(x=0; x<5; x++)
+        thetaEffects[x] = XOR5(lanesIn[x], lanesIn[x+5], lanesIn[x+10], lanesIn[x+15], lanesIn[x+20]);
+    for(lanePosition=0; lanePosition<25; lanePosition++) {
+        x = lanePosition%5;
+        lanesIn[lanePosition] = XOR(lanesIn[lanePosition], XOR(thetaEffects[(x+4)%5], ROL(thetaEffects[(x+1)%5], 1)));
+    }
+    for(x=0; x<5; x++)
+        thetaEffects[x] = _mm256_setzero_si256();
+    counterLaneTemplate = lanesIn[counterLane];
+    for(lanePosition=21; lanePosition<28; lanePosition++)
+        lanesOut[lanePosition] = _mm256_setzero_si256();
+    counters = _mm256_add_epi64(CONST256_64(firstBlock), _mm256_set_epi64x(3, 2, 1, 0));
+
+    while(batchCount-- > 0) {
+        lanesIn[counterLane] = XOR(counterLaneTemplate, counters);
+        thetaEffects[(counterColumn+1)%5] = counters;
+        thetaEffects[(counterColumn+4)%5] = ROL(counters, 1);
+        copyFromState(lanesIn);
+        _Da = thetaEffects[0];
+        _De = thetaEffects[1];
+        _Di = thetaEffects[2];
+        _Do = thetaEffects[3];
+        _Du = thetaEffects[4];
+        if (nrounds == 12) {
+            squeezeRounds12;
+        }
+        else {
+            squeezeRounds24;
+        }
+        copyRateToState(lanesOut);
+        if (interleaved) {
+            for(lanePosition=0; lanePosition<laneCount; lanePosition++)
+                _mm256_storeu_si256((V256*)(data + lanePosition*64 + half*32), lanesOut[lanePosition]);
+            half ^= 1;
+            if (!half)
+                data += 8*rowLengthInBytes;
+        }
+        else {
+            for(lanePosition=0; lanePosition<laneCount; lanePosition+=4)
+                KeccakP1600times4_StoreTransposed(data + lanePosition*SnP_laneLengthInBytes, rowLengthInBytes, laneCount - lanePosition, lanesOut + lanePosition);
+            data += 4*rowLengthInBytes;
+        }
+        counters = _mm256_add_epi64(counters, CONST256_64(4));
+    }
+}
+
+void KeccakP1600times4_SqueezeBlocks(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount)
+{
+    KeccakP1600times4_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, batchCount, 24, 0);
+}
+
+void KeccakP1600times4_12rounds_SqueezeBlocks(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount)
+{
+    KeccakP1600times4_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, batchCount, 12, 0);
+}
+
+void KeccakP1600times4_SqueezeBlocksInterleaved(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount)
+{
+    KeccakP1600times4_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, batchCount, 24, 1);
+}
+
+void KeccakP1600times4_12rounds_SqueezeBlocksInterleaved(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount)
+{
+    KeccakP1600times4_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, batchCount, 12, 1);
+}
+
 size_t KeccakF1600times4_FastLoop_Absorb(void *states, unsigned int laneCount, unsigned int laneOffsetParallel, unsigned int laneOffsetSerial, const unsigned char *data, size_t dataByteLen)
 {
     size_t dataMinimumSize = (laneOffsetParallel*3 + laneCount)*8;
@@ -879,3 +1076,7 @@ size_t KeccakP1600times4_12rounds_FastLoop_Absorb(void *states, unsigned int lan
         return data - dataStart;
     }
 }
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
@@ -19,6 +19,13 @@ This implementation comes with KeccakP-1600-times8-SnP.h in the same folder.
 Please refer to LowLevel.build for the exact list of other files it must be combined with.
 */
 
+/* Always compiled for AVX-512, the implementation is selected at runtime (see vexof.c) */
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx512f")
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -759,7 +766,25 @@ static ALIGN(KeccakP1600times8_statesAlignment) const uint64_t KeccakP1600RoundC
     KeccakP_ThetaRhoPiChi( _L1, _L2, _L3, _L4, _L5, _Bo, _Bu, _Ba, _Be, _Bi, 41,  2, 62, 55, 39 )
 
 #define KeccakP_4rounds( i ) \
-    KeccakP_ThetaRhoPiChiIota0(_ba, _ge, _ki, _mo, _su, CONST8_64(KeccakP1600RoundConstants[i]) ); \
+    KeccakP_4roundsCustom( i, KeccakP_ThetaRhoPiChiIota0, KeccakP_ThetaRhoPiChi4 )
+
+/* First round of SqueezeBlocks: theta was applied to the template in advance, and _Da, ..., _Du only hold the effect of the counters */
+#define KeccakP_RhoPiChiIota0( _L1, _L2, _L3, _L4, _L5, _rc ) \
+    KeccakP_ThetaRhoPiChi( _L1, _L2, _L3, _L4, _L5, _Ba, _Be, _Bi, _Bo, _Bu,  0, 44, 43, 21, 14 ); \
+    _L1 = XOR(_L1, _rc) /* Iota */
+
+/* Last row of the last round of SqueezeBlocks: only _sa is in the rate (of at most 21 lanes) */
+#define KeccakP_ThetaRhoPiChi4Rate( _L1, _L2, _L3, _L4, _L5 ) \
+    _Ba = XOR(_L3, _Di); \
+    _Be = XOR(_L4, _Do); \
+    _Bi = XOR(_L5, _Du); \
+    _Ba = ROL(_Ba, 62); \
+    _Be = ROL(_Be, 55); \
+    _Bi = ROL(_Bi, 39); \
+    _L1 = Chi( _Ba, _Be, _Bi)
+
+#define KeccakP_4roundsCustom( i, _Round0, _LastRow ) \
+    _Round0(_ba, _ge, _ki, _mo, _su, CONST8_64(KeccakP1600RoundConstants[i]) ); \
     KeccakP_ThetaRhoPiChi1(    _ka, _me, _si, _bo, _gu ); \
     KeccakP_ThetaRhoPiChi2(    _sa, _be, _gi, _ko, _mu ); \
     KeccakP_ThetaRhoPiChi3(    _ga, _ke, _mi, _so, _bu ); \
@@ -781,7 +806,7 @@ static ALIGN(KeccakP1600times8_statesAlignment) const uint64_t KeccakP1600RoundC
     KeccakP_ThetaRhoPiChi1(    _ga, _ge, _gi, _go, _gu ); \
     KeccakP_ThetaRhoPiChi2(    _ka, _ke, _ki, _ko, _ku ); \
     KeccakP_ThetaRhoPiChi3(    _ma, _me, _mi, _mo, _mu ); \
-    KeccakP_ThetaRhoPiChi4(    _sa, _se, _si, _so, _su )
+    _LastRow(                  _sa, _se, _si, _so, _su )
 
 #define KeccakP_2rounds( i ) \
     KeccakP_ThetaRhoPiChiIota0(_ba, _ke, _si, _go, _mu, CONST8_64(KeccakP1600RoundConstants[i]) ); \
@@ -851,6 +876,19 @@ static ALIGN(KeccakP1600times8_statesAlignment) const uint64_t KeccakP1600RoundC
 #define rounds4 \
     KeccakP_4rounds( 20 )
 
+#define squeezeRounds12 \
+    KeccakP_4roundsCustom( 12, KeccakP_RhoPiChiIota0, KeccakP_ThetaRhoPiChi4 ); \
+    KeccakP_4rounds( 16 ); \
+    KeccakP_4roundsCustom( 20, KeccakP_ThetaRhoPiChiIota0, KeccakP_ThetaRhoPiChi4Rate )
+
+#define squeezeRounds24 \
+    KeccakP_4roundsCustom( 0, KeccakP_RhoPiChiIota0, KeccakP_ThetaRhoPiChi4 ); \
+    KeccakP_4rounds( 4 ); \
+    KeccakP_4rounds( 8 ); \
+    KeccakP_4rounds( 12 ); \
+    KeccakP_4rounds( 16 ); \
+    KeccakP_4roundsCustom( 20, KeccakP_ThetaRhoPiChiIota0, KeccakP_ThetaRhoPiChi4Rate )
+
 #define copyFromState(pState) \
     _ba = pState[ 0]; \
     _be = pState[ 1]; \
@@ -932,6 +970,30 @@ static ALIGN(KeccakP1600times8_statesAlignment) const uint64_t KeccakP1600RoundC
     pState[23] = _so; \
     pState[24] = _su
 
+/* Only the lanes that SqueezeBlocks extracts, at most 21 */
+#define copyRateToState(pState) \
+    pState[ 0] = _ba; \
+    pState[ 1] = _be; \
+    pState[ 2] = _bi; \
+    pState[ 3] = _bo; \
+    pState[ 4] = _bu; \
+    pState[ 5] = _ga; \
+    pState[ 6] = _ge; \
+    pState[ 7] = _gi; \
+    pState[ 8] = _go; \
+    pState[ 9] = _gu; \
+    pState[10] = _ka; \
+    pState[11] = _ke; \
+    pState[12] = _ki; \
+    pState[13] = _ko; \
+    pState[14] = _ku; \
+    pState[15] = _ma; \
+    pState[16] = _me; \
+    pState[17] = _mi; \
+    pState[18] = _mo; \
+    pState[19] = _mu; \
+    pState[20] = _sa
+
 void KeccakP1600times8_PermuteAll_24rounds(void *states)
 {
     V512 *statesAsLanes = (V512*)states;
@@ -978,6 +1040,126 @@ void KeccakP1600times8_PermuteAll_4rounds(void *states)
     copyToState(statesAsLanes);
 }
 
+#define laneMask(laneCount)  (((laneCount) >= 8) ? (__mmask8)0xFF : (__mmask8)((1 << (laneCount)) - 1))
+
+static void KeccakP1600times8_StoreTransposed(unsigned char *data, unsigned int rowLengthInBytes, __mmask8 mask, const V512 *lanes)
+{
+    V512 t0, t1, t2, t3, t4, t5, t6, t7;
+    V512 r0, r1, r2, r3, r4, r5, r6, r7;
+
+    r0 = _mm512_unpacklo_epi64(lanes[0], lanes[1]);
+    r1 = _mm512_unpackhi_epi64(lanes[0], lanes[1]);
+    r2 = _mm512_unpacklo_epi64(lanes[2], lanes[3]);
+    r3 = _mm512_unpackhi_epi64(lanes[2], lanes[3]);
+    r4 = _mm512_unpacklo_epi64(lanes[4], lanes[5]);
+    r5 = _mm512_unpackhi_epi64(lanes[4], lanes[5]);
+    r6 = _mm512_unpacklo_epi64(lanes[6], lanes[7]);
+    r7 = _mm512_unpackhi_epi64(lanes[6], lanes[7]);
+    t0 = _mm512_shuffle_i32x4(r0, r2, 0x88);
+    t1 = _mm512_shuffle_i32x4(r1, r3, 0x88);
+    t2 = _mm512_shuffle_i32x4(r0, r2, 0xdd);
+    t3 = _mm512_shuffle_i32x4(r1, r3, 0xdd);
+    t4 = _mm512_shuffle_i32x4(r4, r6, 0x88);
+    t5 = _mm512_shuffle_i32x4(r5, r7, 0x88);
+    t6 = _mm512_shuffle_i32x4(r4, r6, 0xdd);
+    t7 = _mm512_shuffle_i32x4(r5, r7, 0xdd);
+    r0 = _mm512_shuffle_i32x4(t0, t4, 0x88);
+    r1 = _mm512_shuffle_i32x4(t1, t5, 0x88);
+    r2 = _mm512_shuffle_i32x4(t2, t6, 0x88);
+    r3 = _mm512_shuffle_i32x4(t3, t7, 0x88);
+    r4 = _mm512_shuffle_i32x4(t0, t4, 0xdd);
+    r5 = _mm512_shuffle_i32x4(t1, t5, 0xdd);
+    r6 = _mm512_shuffle_i32x4(t2, t6, 0xdd);
+    r7 = _mm512_shuffle_i32x4(t3, t7, 0xdd);
+    _mm512_mask_storeu_epi64(data + 0*rowLengthInBytes, mask, r0);
+    _mm512_mask_storeu_epi64(data + 1*rowLengthInBytes, mask, r1);
+    _mm512_mask_storeu_epi64(data + 2*rowLengthInBytes, mask, r2);
+    _mm512_mask_storeu_epi64(data + 3*rowLengthInBytes, mask, r3);
+    _mm512_mask_storeu_epi64(data + 4*rowLengthInBytes, mask, r4);
+    _mm512_mask_storeu_epi64(data + 5*rowLengthInBytes, mask, r5);
+    _mm512_mask_storeu_epi64(data + 6*rowLengthInBytes, mask, r6);
+    _mm512_mask_storeu_epi64(data + 7*rowLengthInBytes, mask, r7);
+}
+
+/* With interleaved set, the blocks are stored in groups of 8 blocks, lane by lane: lane x of block 8*g + i
+ * (counted from firstBlock) at data + (g*laneCount + x)*64 + i*8. A batch is a group. */
+static void KeccakP1600times8_SqueezeBlocksNrounds(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount, unsigned int nrounds, int interleaved)
+{
+    const uint64_t *templateAsLanes = (const uint64_t*)state;
+    ALIGN(KeccakP1600times8_statesAlignment) V512 lanesIn[25];
+    ALIGN(KeccakP1600times8_statesAlignment) V512 lanesOut[32];
+    unsigned int rowLengthInBytes = laneCount*SnP_laneLengthInBytes;
+    unsigned int lanePosition;
+    unsigned int counterColumn = counterLane%5;
+    unsigned int x;
+    V512 counterLaneTemplate, counters, thetaEffects[5];
+    KeccakP_DeclareVars;
+
+    for(lanePosition=0; lanePosition<25; lanePosition++)
+        lanesIn[lanePosition] = CONST8_64(templateAsLanes[lanePosition]);
+    /* Theta of the first round only depends on the counters through the parity of their column:
+     * apply it to the template once, and add the effect of the counters per batch. */
+    for(x=0; x<5; x++)
+        thetaEffects[x] = XOR5(lanesIn[x], lanesIn[x+5], lanesIn[x+10], lanesIn[x+15], lanesIn[x+20]);
+    for(lanePosition=0; lanePosition<25; lanePosition++) {
+        x = lanePosition%5;
+        lanesIn[lanePosition] = XOR(lanesIn[lanePosition], XOR(thetaEffects[(x+4)%5], ROL(thetaEffects[(x+1)%5], 1)));
+    }
+    for(x=0; x<5; x++)
+        thetaEffects[x] = _mm512_setzero_si512();
+    counterLaneTemplate = lanesIn[counterLane];
+    for(lanePosition=21; lanePosition<32; lanePosition++)
+        lanesOut[lanePosition] = _mm512_setzero_si512();
+    counters = _mm512_add_epi64(CONST8_64(firstBlock), LOAD8_64(7, 6, 5, 4, 3, 2, 1, 0));
+
+    while(batchCount-- > 0) {
+        lanesIn[counterLane] = XOR(counterLaneTemplate, counters);
+        thetaEffects[(counterColumn+1)%5] = counters;
+        thetaEffects[(counterColumn+4)%5] = ROL(counters, 1);
+        copyFromState(lanesIn);
+        _Da = thetaEffects[0];
+        _De = thetaEffects[1];
+        _Di = thetaEffects[2];
+        _Do = thetaEffects[3];
+        _Du = thetaEffects[4];
+        if (nrounds == 12) {
+            squeezeRounds12;
+        }
+        else {
+            squeezeRounds24;
+        }
+        copyRateToState(lanesOut);
+        if (interleaved)
+            for(lanePosition=0; lanePosition<laneCount; lanePosition++)
+                _mm512_storeu_si512((V512*)(data + lanePosition*64), lanesOut[lanePosition]);
+        else
+            for(lanePosition=0; lanePosition<laneCount; lanePosition+=8)
+                KeccakP1600times8_StoreTransposed(data + lanePosition*SnP_laneLengthInBytes, rowLengthInBytes, laneMask(laneCount - lanePosition), lanesOut + lanePosition);
+        counters = _mm512_add_epi64(counters, CONST8_64(8));
+        data += 8*rowLengthInBytes;
+    }
+}
+
+void KeccakP1600times8_SqueezeBlocks(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount)
+{
+    KeccakP1600times8_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, batchCount, 24, 0);
+}
+
+void KeccakP1600times8_12rounds_SqueezeBlocks(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount)
+{
+    KeccakP1600times8_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, batchCount, 12, 0);
+}
+
+void KeccakP1600times8_SqueezeBlocksInterleaved(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount)
+{
+    KeccakP1600times8_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, batchCount, 24, 1);
+}
+
+void KeccakP1600times8_12rounds_SqueezeBlocksInterleaved(const void *state, unsigned int laneCount, unsigned int counterLane, uint64_t firstBlock, unsigned char *data, size_t batchCount)
+{
+    KeccakP1600times8_SqueezeBlocksNrounds(state, laneCount, counterLane, firstBlock, data, batchCount, 12, 1);
+}
+
 size_t KeccakF1600times8_FastLoop_Absorb(void *states, unsigned int laneCount, unsigned int laneOffsetParallel, unsigned int laneOffsetSerial, const unsigned char *data, size_t dataByteLen)
 {
     size_t dataMinimumSize = (laneOffsetParallel*7 + laneCount)*8;
@@ -1613,3 +1795,7 @@ size_t KeccakP1600times8_KravatteExpand(uint64_t *yAccu, const uint64_t *kRoll,
 
     return (size_t)o64 - (size_t)output;
 }
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
@@ -65,6 +65,9 @@ http://creativecommons.org/publicdomain/zero/1.0/
     XKCP_DeclareSpongeStructure(KeccakWidth1600, KeccakP1600_stateSizeInBytes, KeccakP1600_stateAlignment)
     XKCP_DeclareSpongeFunctions(KeccakWidth1600)
     #define XKCP_has_Sponge_Keccak_width1600
+    XKCP_DeclareSpongeStructure(KeccakWidth1600_12rounds, KeccakP1600_stateSizeInBytes, KeccakP1600_stateAlignment)
+    XKCP_DeclareSpongeFunctions(KeccakWidth1600_12rounds)
+    #define XKCP_has_Sponge_Keccak_width1600_12rounds
 #endif
 
 #endif
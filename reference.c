@@ -13,7 +13,8 @@
 #include <assert.h>
 
 /**
- * Reference version for testing compliance to the specification.
+ * Reference version for testing compliance to the specification. The instance is either a SHAKE128
+ * or a SHAKE256 instance, the size of the blocks follows from its rate.
  */
 int VeXOF_Reference(Keccak_HashInstance *instance_arg, uint8_t *data, size_t num_bytes)
 {
@@ -45,3 +46,66 @@ int VeXOF_Reference(Keccak_HashInstance *instance_arg, uint8_t *data, size_t num
 
     return 0;
 }
+
+/**
+ * Reference version of VeXOF based on TurboSHAKE. Block i is TurboSHAKE(seed || LE64(i), domain) with
+ * the seed absorbed in instance_arg.
+ */
+int VeXOF_Reference_TurboSHAKE(const KeccakWidth1600_12rounds_SpongeInstance *instance_arg, unsigned char domain,
+                               uint8_t *data, size_t num_bytes)
+{
+    KeccakWidth1600_12rounds_SpongeInstance spongeInstance;
+
+    assert(num_bytes % 64 == 0);
+    assert(!instance_arg->squeezing);
+
+    size_t index = 0;
+    uint64_t block = 0;
+
+    while (index < num_bytes)
+    {
+        memcpy(&spongeInstance, instance_arg, sizeof(KeccakWidth1600_12rounds_SpongeInstance));
+        KeccakWidth1600_12rounds_SpongeAbsorb(&spongeInstance, (uint8_t *)&block, 8);
+        KeccakWidth1600_12rounds_SpongeAbsorbLastFewBits(&spongeInstance, domain);
+        block++;
+
+        size_t bytes = num_bytes - index;
+        if (bytes > (instance_arg->rate / 8))
+            bytes = (instance_arg->rate / 8);
+
+        KeccakWidth1600_12rounds_SpongeSqueeze(&spongeInstance, data, bytes);
+
+        data += bytes;
+        index += bytes;
+    }
+
+    return 0;
+}
+
+/**
+ * Reference version of the interleaved order: the blocks of VeXOF_Reference in groups of 8, stored lane by
+ * lane.
+ */
+int VeXOF_Reference_Interleaved(Keccak_HashInstance *instance_arg, uint8_t *data, size_t num_bytes)
+{
+    uint32_t bytes_rate = instance_arg->sponge.rate / 8;
+    size_t group_bytes = 8 * bytes_rate;
+    size_t num_groups = (num_bytes + group_bytes - 1) / group_bytes;
+    uint8_t *blocks = malloc(num_groups * group_bytes);
+
+    assert(num_bytes % 64 == 0);
+    assert(blocks);
+
+    VeXOF_Reference(instance_arg, blocks, num_groups * group_bytes);
+
+    for (size_t index = 0; index < num_bytes; index += 8)
+    {
+        size_t group = index / group_bytes;
+        size_t lane = index % group_bytes / 64;
+        size_t block = index % 64 / 8;
+        memcpy(data + index, blocks + group * group_bytes + block * bytes_rate + lane * 8, 8);
+    }
+
+    free(blocks);
+    return 0;
+}
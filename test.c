@@ -9,6 +9,9 @@
 #include <openssl/evp.h>
 #include "vexof.h"
 int VeXOF_Reference(Keccak_HashInstance *instance_arg, uint8_t *data, size_t dataByteLen);
+int VeXOF_Reference_TurboSHAKE(const KeccakWidth1600_12rounds_SpongeInstance *instance_arg, unsigned char domain,
+                               uint8_t *data, size_t num_bytes);
+int VeXOF_Reference_Interleaved(Keccak_HashInstance *instance_arg, uint8_t *data, size_t num_bytes);
 
 #define MAX_XOF_BYTES 4000000
 #define NUM_XOF_BYTES 32960
@@ -16,6 +19,9 @@ int VeXOF_Reference(Keccak_HashInstance *instance_arg, uint8_t *data, size_t dat
 #define TEST_NUM 2500
 
 // #define REPORT_TIME
+#if !defined(REPORT_TIME) && !defined(__x86_64__)
+#define REPORT_TIME
+#endif
 #ifdef REPORT_TIME
 static inline uint64_t ticks(void)
 {
@@ -35,6 +41,24 @@ static inline uint64_t ticks(void)
 
 #endif
 
+struct stream_context
+{
+    uint8_t *output;
+    size_t num_bytes;
+    size_t max_chunk;
+    size_t stop_after;
+};
+
+int stream_consumer(void *context, const uint8_t *data, size_t num_bytes)
+{
+    struct stream_context *stream = context;
+    memcpy(stream->output + stream->num_bytes, data, num_bytes);
+    stream->num_bytes += num_bytes;
+    if (num_bytes > stream->max_chunk)
+        stream->max_chunk = num_bytes;
+    return stream->num_bytes >= stream->stop_after ? 2 : 0;
+}
+
 void print_results(const char *s, uint64_t *t, size_t tlenarg, size_t numbytes)
 {
     size_t tlen = tlenarg - 1;
@@ -86,6 +110,68 @@ void vexof_ref(const uint8_t *pt_seed_array, int input_bytes, uint64_t *pt_outpu
     VeXOF_Reference(&hashInstance, (uint8_t *)pt_output_array, output_bytes);
 }
 
+void xkcp256(const uint8_t *pt_seed_array, int input_bytes, uint8_t *pt_output_array,
+             int output_bytes)
+{
+    Keccak_HashInstance hashInstance;
+    Keccak_HashInitialize_SHAKE256(&hashInstance);
+    Keccak_HashUpdate(&hashInstance, pt_seed_array, 8 * input_bytes);
+    Keccak_HashFinal(&hashInstance, pt_output_array);
+    Keccak_HashSqueeze(&hashInstance, pt_output_array, 8 * output_bytes);
+}
+
+void vexof256(const uint8_t *pt_seed_array, int input_bytes, uint64_t *pt_output_array,
+              int output_bytes)
+{
+    VeXOF_Instance vexofInstance;
+    VeXOF_HashInitialize_SHAKE256(&vexofInstance);
+    VeXOF_HashUpdate(&vexofInstance, pt_seed_array, input_bytes);
+    VeXOF_Squeeze(&vexofInstance, pt_output_array, output_bytes);
+}
+
+void vexof256_ref(const uint8_t *pt_seed_array, int input_bytes, uint64_t *pt_output_array,
+                  int output_bytes)
+{
+    Keccak_HashInstance hashInstance;
+    Keccak_HashInitialize_SHAKE256(&hashInstance);
+    Keccak_HashUpdate(&hashInstance, pt_seed_array, 8 * input_bytes);
+    VeXOF_Reference(&hashInstance, (uint8_t *)pt_output_array, output_bytes);
+}
+
+void vexof_turbo(const uint8_t *pt_seed_array, int input_bytes, int rate, uint8_t domain,
+                 uint64_t *pt_output_array, int output_bytes)
+{
+    VeXOF_Instance vexofInstance;
+    if (rate == 168)
+        VeXOF_HashInitialize_TurboSHAKE128(&vexofInstance, domain);
+    else
+        VeXOF_HashInitialize_TurboSHAKE256(&vexofInstance, domain);
+    VeXOF_HashUpdate(&vexofInstance, pt_seed_array, input_bytes);
+    VeXOF_Squeeze(&vexofInstance, pt_output_array, output_bytes);
+}
+
+void vexof_turbo_ref(const uint8_t *pt_seed_array, int input_bytes, int rate, uint8_t domain,
+                     uint64_t *pt_output_array, int output_bytes)
+{
+    KeccakWidth1600_12rounds_SpongeInstance spongeInstance;
+    KeccakWidth1600_12rounds_SpongeInitialize(&spongeInstance, 8 * rate, 1600 - 8 * rate);
+    KeccakWidth1600_12rounds_SpongeAbsorb(&spongeInstance, pt_seed_array, input_bytes);
+    VeXOF_Reference_TurboSHAKE(&spongeInstance, domain, (uint8_t *)pt_output_array, output_bytes);
+}
+
+int hex_equal(const void *data, const char *hex)
+{
+    const uint8_t *data8 = (const uint8_t *)data;
+    for (size_t idx = 0; hex[2 * idx]; idx++)
+    {
+        unsigned int byte;
+        sscanf(&hex[2 * idx], "%2x", &byte);
+        if (data8[idx] != byte)
+            return 0;
+    }
+    return 1;
+}
+
 void shake128(const uint8_t *pt_seed_array, int input_bytes, uint8_t *pt_output_array,
               int output_bytes)
 {
@@ -174,52 +260,1424 @@ int main()
         }
     }
 
-    // Report timings
-    printf("\nXKCP and VeXOF compared to OpenSSL for %d bytes (%d times)\n", NUM_XOF_BYTES, TEST_NUM);
+    // Test short squeezes, which use narrower batches
+    {
+        vexof_ref(pt_public_key_seed, 16, prng_output_public_c, NUM_XOF_BYTES);
+        memset(prng_output_public, 0, NUM_XOF_BYTES);
 
-    for (int count = 0; count < TEST_NUM; count++)
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+
+        const size_t lengths[] = {8, 160, 168, 336, 504, 16, 672, 840, 1344, 1352, 8, 336};
+        size_t offset = 0;
+        for (size_t idx = 0; idx < sizeof(lengths) / sizeof(lengths[0]); idx++)
+        {
+            VeXOF_Squeeze(&vexofInstance, &prng_output_public[offset / 8], lengths[idx]);
+            offset += lengths[idx];
+        }
+
+        if (memcmp(prng_output_public, prng_output_public_c, offset) == 0)
+        {
+            printf("Short squeeze test ok\n");
+        }
+        else
+        {
+            printf("Short squeeze test Failed\n");
+        }
+    }
+
+    // Test squeezes of odd lengths to an unaligned buffer
     {
-        test_cycles[count] = ticks();
-        pt_public_key_seed[0] = count % 256;
-        pt_public_key_seed[1] = count / 256;
-        hash_aes128(pt_public_key_seed, (uint8_t *)prng_output_public);
+        vexof_ref(pt_public_key_seed, 16, prng_output_public_c, NUM_XOF_BYTES);
+        memset(prng_output_public, 0, NUM_XOF_BYTES);
+
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+
+        const size_t lengths[] = {1, 7, 21, 13, 168, 1000, 3, 1345, 0, 5, 2691, 8, 999};
+        uint8_t *output = (uint8_t *)prng_output_public + 1;
+        size_t offset = 0;
+        for (size_t idx = 0; idx < sizeof(lengths) / sizeof(lengths[0]); idx++)
+        {
+            VeXOF_SqueezeBytes(&vexofInstance, output + offset, lengths[idx]);
+            offset += lengths[idx];
+        }
+
+        if (memcmp(output, prng_output_public_c, offset) == 0)
+        {
+            printf("Byte squeeze test ok\n");
+        }
+        else
+        {
+            printf("Byte squeeze test Failed\n");
+        }
     }
-    print_results("AES:\t", test_cycles, TEST_NUM, NUM_XOF_BYTES);
 
-    for (int count = 0; count < TEST_NUM; count++)
+    // Test word and byte pulls, mixed with squeezes
     {
-        test_cycles[count] = ticks();
-        shake128(pt_public_key_seed, 16, (uint8_t *)prng_output_public, NUM_XOF_BYTES);
+        vexof_ref(pt_public_key_seed, 16, prng_output_public_c, NUM_XOF_BYTES);
+        memset(prng_output_public, 0, NUM_XOF_BYTES);
+
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+
+        uint8_t *output = (uint8_t *)prng_output_public;
+        size_t offset = 0;
+        for (int idx = 0; idx < 500; idx++, offset += 8)
+        {
+            uint64_t word = VeXOF_Next64(&vexofInstance);
+            memcpy(output + offset, &word, 8);
+        }
+        const size_t lengths[] = {3, 1, 168, 2000, 5, 64};
+        int ret = 0;
+        for (size_t idx = 0; idx < sizeof(lengths) / sizeof(lengths[0]); idx++)
+        {
+            ret |= VeXOF_NextBytes(&vexofInstance, output + offset, lengths[idx]);
+            offset += lengths[idx];
+        }
+        VeXOF_SqueezeBytes(&vexofInstance, output + offset, 1001);
+        offset += 1001;
+        for (int idx = 0; idx < 500; idx++, offset += 8)
+        {
+            uint64_t word = VeXOF_Next64(&vexofInstance);
+            memcpy(output + offset, &word, 8);
+        }
+
+        if (ret == 0 && memcmp(output, prng_output_public_c, offset) == 0)
+        {
+            printf("Next64 test ok\n");
+        }
+        else
+        {
+            printf("Next64 test Failed\n");
+        }
     }
-    print_results("openssl:", test_cycles, TEST_NUM, NUM_XOF_BYTES);
 
-    for (int count = 0; count < TEST_NUM; count++)
+    // Test seed lengths around the end of a block against reference
     {
-        test_cycles[count] = ticks();
-        pt_public_key_seed[0] = count % 256;
-        pt_public_key_seed[1] = count / 256;
-        xkcp(pt_public_key_seed, 16, (uint8_t *)prng_output_public, NUM_XOF_BYTES);
+        const size_t seed_lens[] = {0, 7, 120, 127, 128, 129, 135, 136, 152, 153, 159, 160, 161, 167, 168, 169, 264, 328, 335};
+        enum { NUM_SEEDS = sizeof(seed_lens) / sizeof(seed_lens[0]), OUTPUT_BYTES = 3008 };
+        uint8_t seed[400];
+        uint8_t *output = (uint8_t *)prng_output_public;
+        uint8_t *reference = (uint8_t *)prng_output_public_c;
+
+        for (int idx = 0; idx < 400; idx++)
+            seed[idx] = idx * 13 + 5;
+
+        testok = 1;
+        for (int idx = 0; idx < NUM_SEEDS; idx++)
+        {
+            size_t len = seed_lens[idx];
+            VeXOF_Instance vexofInstance;
+
+            vexof_ref(seed, len, prng_output_public_c, OUTPUT_BYTES);
+            VeXOF_HashInitialize(&vexofInstance);
+            VeXOF_HashUpdate(&vexofInstance, seed, len);
+            VeXOF_SqueezeBytes(&vexofInstance, output, 1);
+            VeXOF_SqueezeBytes(&vexofInstance, output + 1, 1000);
+            VeXOF_SqueezeBytes(&vexofInstance, output + 1001, OUTPUT_BYTES - 1001);
+            testok &= memcmp(output, reference, OUTPUT_BYTES) == 0;
+
+            memset(output, 0, OUTPUT_BYTES);
+            VeXOF_SqueezeAt(&vexofInstance, 1352, prng_output_public, 1000);
+            testok &= memcmp(output, reference + 1352, 1000) == 0;
+
+            vexof(seed, len, prng_output_public, 160);
+            testok &= memcmp(output, reference, 160) == 0;
+            vexof(seed, len, prng_output_public, OUTPUT_BYTES);
+            testok &= memcmp(output, reference, OUTPUT_BYTES) == 0;
+
+            const uint8_t *seed_ptr = seed;
+            size_t out_len = 500;
+            VeXOF_BatchSqueeze(&seed_ptr, &len, &output, &out_len, 1);
+            testok &= memcmp(output, reference, out_len) == 0;
+
+            vexof256_ref(seed, len, prng_output_public_c, OUTPUT_BYTES);
+            VeXOF_HashInitialize_SHAKE256(&vexofInstance);
+            VeXOF_HashUpdate(&vexofInstance, seed, len);
+            VeXOF_SqueezeBytes(&vexofInstance, output, OUTPUT_BYTES);
+            testok &= memcmp(output, reference, OUTPUT_BYTES) == 0;
+
+            vexof_turbo_ref(seed, len, 168, 0x1F, prng_output_public_c, OUTPUT_BYTES);
+            VeXOF_HashInitialize_TurboSHAKE128(&vexofInstance, 0x1F);
+            VeXOF_HashUpdate(&vexofInstance, seed, len);
+            VeXOF_SqueezeBytes(&vexofInstance, output, OUTPUT_BYTES);
+            testok &= memcmp(output, reference, OUTPUT_BYTES) == 0;
+
+            if (!testok)
+            {
+                printf("Seed length test Failed @ %zu bytes\n", len);
+                break;
+            }
+        }
+        if (testok)
+        {
+            printf("Seed length test ok\n");
+        }
     }
-    print_results("XKCP:\t", test_cycles, TEST_NUM, NUM_XOF_BYTES);
 
-    memset(prng_output_public, 0, NUM_XOF_BYTES);
-    for (int count = 0; count < TEST_NUM; count++)
+    // Test outputs of one block, with seeds up to the longest that leaves room for the index and padding
+    {
+        const size_t seed_lens[] = {0, 13, 16, 151, 152, 153, 158, 159, 160};
+        uint8_t seed[160];
+        uint8_t *output = (uint8_t *)prng_output_public;
+        uint8_t *reference = (uint8_t *)prng_output_public_c;
+
+        for (int idx = 0; idx < 160; idx++)
+            seed[idx] = idx * 7 + 3;
+
+        testok = 1;
+        for (size_t idx = 0; idx < sizeof(seed_lens) / sizeof(seed_lens[0]); idx++)
+        {
+            vexof_ref(seed, seed_lens[idx], prng_output_public_c, 192);
+            for (size_t bytes = 1; bytes <= 168; bytes++)
+            {
+                memset(output, 0, 176);
+                vexof(seed, seed_lens[idx], prng_output_public, bytes);
+                if (memcmp(output, reference, bytes) || output[bytes] != 0)
+                {
+                    printf("Single block test Failed @ seed %zu bytes, output %zu bytes\n", seed_lens[idx], bytes);
+                    testok = 0;
+                    break;
+                }
+            }
+        }
+        if (testok)
+        {
+            printf("Single block test ok\n");
+        }
+    }
+
+    // Test non-temporal stores
+    {
+        vexof(pt_public_key_seed, 16, prng_output_public_c, NUM_XOF_BYTES);
+
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+        uint8_t *output = (uint8_t *)prng_output_public + 3;
+        VeXOF_SetStreaming(1);
+        VeXOF_SqueezeBytes(&vexofInstance, output, 5);
+        VeXOF_SqueezeBytes(&vexofInstance, output + 5, 20000);
+        VeXOF_SqueezeBytes(&vexofInstance, output + 20005, NUM_XOF_BYTES - 20005);
+        VeXOF_SetStreaming(0);
+
+        if (memcmp(output, prng_output_public_c, NUM_XOF_BYTES) == 0)
+        {
+            printf("Streaming test ok\n");
+        }
+        else
+        {
+            printf("Streaming test Failed\n");
+        }
+    }
+
+    // Test squeezing to a consumer
+    {
+        vexof(pt_public_key_seed, 16, prng_output_public_c, NUM_XOF_BYTES);
+        memset(prng_output_public, 0, NUM_XOF_BYTES);
+
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+
+        struct stream_context stream = {(uint8_t *)prng_output_public, 0, 0, SIZE_MAX};
+        testok = VeXOF_SqueezeStream(&vexofInstance, 5, 0, stream_consumer, &stream) == 0;
+        testok &= VeXOF_SqueezeStream(&vexofInstance, 20000, 1001, stream_consumer, &stream) == 0;
+        testok &= stream.max_chunk == 1001;
+        testok &= VeXOF_SqueezeStream(&vexofInstance, NUM_XOF_BYTES - 20005, 0, stream_consumer, &stream) == 0;
+        testok &= stream.num_bytes == NUM_XOF_BYTES && stream.max_chunk == NUM_XOF_BYTES - 20005;
+        testok &= memcmp(prng_output_public, prng_output_public_c, NUM_XOF_BYTES) == 0;
+
+        // The consumer stops the squeeze
+        stream.stop_after = NUM_XOF_BYTES + 3000;
+        testok &= VeXOF_SqueezeStream(&vexofInstance, 100000, 1000, stream_consumer, &stream) == 2;
+        testok &= stream.num_bytes == NUM_XOF_BYTES + 3000;
+
+        if (testok)
+        {
+            printf("Consumer test ok\n");
+        }
+        else
+        {
+            printf("Consumer test Failed\n");
+        }
+    }
+
+    // Test rows and lists of buffers
+    {
+        uint8_t *output = (uint8_t *)prng_output_public;
+        uint8_t *reference = (uint8_t *)prng_output_public_c;
+        const size_t row_bytes[] = {1, 100, 1344, 2000};
+
+        vexof(pt_public_key_seed, 16, prng_output_public_c, NUM_XOF_BYTES);
+        testok = 1;
+
+        for (size_t idx = 0; idx < sizeof(row_bytes) / sizeof(row_bytes[0]); idx++)
+        {
+            size_t stride = row_bytes[idx] + 13, num_rows = NUM_XOF_BYTES / stride;
+            VeXOF_Instance vexofInstance;
+            VeXOF_HashInitialize(&vexofInstance);
+            VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+            memset(output, 0xA5, num_rows * stride);
+            VeXOF_SqueezeRows(&vexofInstance, output, row_bytes[idx], stride, num_rows);
+            for (size_t row = 0; row < num_rows; row++)
+            {
+                testok &= memcmp(output + row * stride, reference + row * row_bytes[idx], row_bytes[idx]) == 0;
+                for (size_t pad = row_bytes[idx]; pad < stride; pad++)
+                    testok &= output[row * stride + pad] == 0xA5;
+            }
+        }
+
+        const size_t lens[] = {3, 0, 1344, 5, 9000, 168, 20000};
+        struct iovec iov[sizeof(lens) / sizeof(lens[0])];
+        size_t offset = 0;
+        for (size_t idx = 0; idx < sizeof(lens) / sizeof(lens[0]); idx++)
+        {
+            // Reversed order in memory
+            iov[idx].iov_base = output + NUM_XOF_BYTES - offset - lens[idx];
+            iov[idx].iov_len = lens[idx];
+            offset += lens[idx];
+        }
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+        VeXOF_SqueezeScatter(&vexofInstance, iov, sizeof(lens) / sizeof(lens[0]));
+        offset = 0;
+        for (size_t idx = 0; idx < sizeof(lens) / sizeof(lens[0]); idx++)
+        {
+            testok &= memcmp(iov[idx].iov_base, reference + offset, lens[idx]) == 0;
+            offset += lens[idx];
+        }
+
+        // Tiles of a matrix, column-major fill, and continuation with VeXOF_SqueezeBytes, also for a seed of
+        // which the block index is not in a lane
+        const size_t scatter_seeds[] = {16, 13};
+        for (size_t idx = 0; idx < sizeof(scatter_seeds) / sizeof(scatter_seeds[0]); idx++)
+        {
+            enum { ROW_STRIDE = 800, TILE_BYTES = 100, TILE_ROWS = 3, ACROSS = 7, DOWN = 4 };
+            enum { TILE_OUT = TILE_BYTES * TILE_ROWS * ACROSS * DOWN, COLS = 50, ROWS = 24 };
+            Keccak_HashInstance hashInstance;
+            Keccak_HashInitialize_SHAKE128(&hashInstance);
+            Keccak_HashUpdate(&hashInstance, pt_public_key_seed, 8 * scatter_seeds[idx]);
+            VeXOF_Reference(&hashInstance, reference, NUM_XOF_BYTES);
+
+            VeXOF_HashInitialize(&vexofInstance);
+            VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, scatter_seeds[idx]);
+            VeXOF_SqueezeBytes(&vexofInstance, output, 5);
+            testok &= memcmp(output, reference, 5) == 0;
+
+            VeXOF_SqueezeTiles(&vexofInstance, output, ROW_STRIDE, TILE_BYTES, TILE_ROWS, ACROSS, DOWN);
+            size_t index = 5;
+            for (size_t tile_row = 0; tile_row < DOWN; tile_row++)
+                for (size_t tile = 0; tile < ACROSS; tile++)
+                    for (size_t row = 0; row < TILE_ROWS; row++, index += TILE_BYTES)
+                        testok &= memcmp(output + (tile_row * TILE_ROWS + row) * ROW_STRIDE + tile * TILE_BYTES,
+                                         reference + index, TILE_BYTES) == 0;
+
+            // 8 byte elements of a column-major matrix with columns of ROWS + 2 elements
+            VeXOF_SqueezeTiles(&vexofInstance, output, 8 * (ROWS + 2), 8, COLS, ROWS, 1);
+            for (size_t row = 0; row < ROWS; row++)
+                for (size_t col = 0; col < COLS; col++, index += 8)
+                    testok &= memcmp(output + col * 8 * (ROWS + 2) + row * 8, reference + index, 8) == 0;
+
+            VeXOF_SqueezeBytes(&vexofInstance, output, 3000);
+            testok &= memcmp(output, reference + index, 3000) == 0;
+        }
+
+        if (testok)
+        {
+            printf("Scatter test ok\n");
+        }
+        else
+        {
+            printf("Scatter test Failed\n");
+        }
+    }
+
+    // Test XOR of the output into data
+    {
+        uint8_t *data = (uint8_t *)prng_output_public;
+        uint8_t *output = (uint8_t *)prng_output_public_c;
+
+        vexof(pt_public_key_seed, 16, prng_output_public_c, NUM_XOF_BYTES);
+        for (int idx = 0; idx < NUM_XOF_BYTES + 1; idx++)
+            data[idx] = idx * 11;
+        for (int idx = 0; idx < NUM_XOF_BYTES; idx++)
+            output[idx] ^= data[idx + 1];
+
+        // In place, in pieces of odd sizes and alignment
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+        VeXOF_SqueezeXor(&vexofInstance, data + 1, data + 1, 7);
+        VeXOF_SqueezeXor(&vexofInstance, data + 8, data + 8, 20000);
+        VeXOF_SqueezeXor(&vexofInstance, data + 20008, data + 20008, NUM_XOF_BYTES - 20007);
+        testok = memcmp(data + 1, output, NUM_XOF_BYTES) == 0;
+
+        // To another buffer, which restores the data
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+        VeXOF_SqueezeXor(&vexofInstance, data + 1, output, NUM_XOF_BYTES);
+        for (int idx = 0; idx < NUM_XOF_BYTES; idx++)
+            testok &= output[idx] == (uint8_t)((idx + 1) * 11);
+
+        if (testok)
+        {
+            printf("XOR test ok\n");
+        }
+        else
+        {
+            printf("XOR test Failed\n");
+        }
+    }
+
+    // Test random access squeeze
     {
-        test_cycles[count] = ticks();
-        pt_public_key_seed[0] = count % 256;
-        pt_public_key_seed[1] = count / 256;
         vexof(pt_public_key_seed, 16, prng_output_public, NUM_XOF_BYTES);
+
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+
+        testok = 1;
+        const size_t offsets[] = {0, 8, 160, 168, 1344, 1352, 5000, 30000};
+        const size_t lengths[] = {8, 16, 168, 1344, 2696};
+        for (size_t idx1 = 0; idx1 < sizeof(offsets) / sizeof(offsets[0]); idx1++)
+            for (size_t idx2 = 0; idx2 < sizeof(lengths) / sizeof(lengths[0]); idx2++)
+            {
+                size_t offset = offsets[idx1], length = lengths[idx2];
+                if (offset + length > NUM_XOF_BYTES)
+                    continue;
+                memset(prng_output_public_c, 0, length);
+                VeXOF_SqueezeAt(&vexofInstance, offset, prng_output_public_c, length);
+                if (memcmp(&prng_output_public[offset / 8], prng_output_public_c, length))
+                {
+                    printf("SqueezeAt test Failed @ %zu, %zu bytes\n", offset, length);
+                    testok = 0;
+                }
+            }
+
+        // Any byte position and length
+        const size_t byte_offsets[] = {1, 7, 161, 167, 1343, 5001};
+        const size_t byte_lengths[] = {1, 13, 167, 1345, 2701};
+        for (size_t idx1 = 0; idx1 < sizeof(byte_offsets) / sizeof(byte_offsets[0]); idx1++)
+            for (size_t idx2 = 0; idx2 < sizeof(byte_lengths) / sizeof(byte_lengths[0]); idx2++)
+            {
+                size_t offset = byte_offsets[idx1], length = byte_lengths[idx2];
+                uint8_t *output = (uint8_t *)prng_output_public_c + 3;
+                memset(output, 0, length + 1);
+                VeXOF_SqueezeBytesAt(&vexofInstance, offset, output, length);
+                if (memcmp((const uint8_t *)prng_output_public + offset, output, length) || output[length])
+                {
+                    printf("SqueezeAt test Failed @ %zu, %zu bytes\n", offset, length);
+                    testok = 0;
+                }
+            }
+        if (testok)
+        {
+            printf("SqueezeAt test ok\n");
+        }
     }
-    print_results("VeXOF:\t", test_cycles, TEST_NUM, NUM_XOF_BYTES);
 
-    for (int count = 0; count < TEST_NUM; count++)
+    // Test squeeze of blocks at arbitrary indices
     {
-        test_cycles[count] = ticks();
-        pt_public_key_seed[0] = count % 256;
-        pt_public_key_seed[1] = count / 256;
-        vexof_ref(pt_public_key_seed, 16, prng_output_public_c, NUM_XOF_BYTES);
+        uint8_t *output = (uint8_t *)prng_output_public_c;
+        uint8_t expected[168];
+        const uint64_t indices[] = {3, 0, 195, 17, 17, 1000000007, 4, 1ull << 40, 5, 6, 7, 8, 9, 1, 2, 150};
+        const size_t num_indices = sizeof(indices) / sizeof(indices[0]);
+        const size_t seed_lens[] = {16, 13, 152, 160, 165};
+
+        testok = 1;
+        for (size_t idx = 0; idx < sizeof(seed_lens) / sizeof(seed_lens[0]); idx++)
+            for (size_t num_blocks = 1; num_blocks <= num_indices; num_blocks += 5)
+            {
+                VeXOF_Instance vexofInstance;
+                VeXOF_HashInitialize(&vexofInstance);
+                VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, seed_lens[idx]);
+                VeXOF_SqueezeBlocks(&vexofInstance, indices, num_blocks, output);
+                for (size_t block = 0; block < num_blocks; block++)
+                {
+                    VeXOF_SqueezeAt(&vexofInstance, indices[block] * 168, (uint64_t *)expected, 168);
+                    if (memcmp(output + block * 168, expected, 168))
+                    {
+                        printf("Blocks test Failed @ seed %zu bytes, block %zu\n", seed_lens[idx], block);
+                        testok = 0;
+                    }
+                }
+            }
+
+        // Against the sequential output
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+        VeXOF_SqueezeBlocks(&vexofInstance, indices, num_indices, output);
+        vexof(pt_public_key_seed, 16, prng_output_public, NUM_XOF_BYTES);
+        for (size_t block = 0; block < num_indices; block++)
+            if (indices[block] < NUM_XOF_BYTES / 168)
+                testok &= memcmp(output + block * 168, (uint8_t *)prng_output_public + indices[block] * 168, 168) == 0;
+
+        if (testok)
+        {
+            printf("Blocks test ok\n");
+        }
+        else
+        {
+            printf("Blocks test Failed\n");
+        }
+    }
+
+    // Test export and import of instances
+    {
+        uint8_t *output = (uint8_t *)prng_output_public_c;
+        uint8_t exported[VEXOF_EXPORT_BYTES];
+        VeXOF_Instance vexofInstance, restored;
+
+        vexof(pt_public_key_seed, 96, prng_output_public, NUM_XOF_BYTES);
+        testok = 1;
+
+        // Absorbing, with more input after the import
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 41);
+        VeXOF_Export(&vexofInstance, exported);
+        testok &= VeXOF_Import(&restored, exported) == 0;
+        VeXOF_HashUpdate(&restored, (const uint8_t *)pt_public_key_seed + 41, 55);
+        VeXOF_SqueezeBytes(&restored, output, NUM_XOF_BYTES);
+        testok &= memcmp(prng_output_public, output, NUM_XOF_BYTES) == 0;
+
+        // Squeezing, at the start, inside and at the end of a block
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 96);
+        const size_t offsets[] = {0, 1, 167, 168, 1344, 1345, 5001};
+        size_t position = 0;
+        for (size_t idx = 0; idx < sizeof(offsets) / sizeof(offsets[0]); idx++)
+        {
+            VeXOF_SqueezeBytes(&vexofInstance, output, offsets[idx] - position);
+            position = offsets[idx];
+            VeXOF_Export(&vexofInstance, exported);
+            memset(output, 0, 2000);
+            testok &= VeXOF_Import(&restored, exported) == 0;
+            VeXOF_SqueezeBytes(&restored, output, 2000);
+            testok &= memcmp((const uint8_t *)prng_output_public + position, output, 2000) == 0;
+        }
+
+        // TurboSHAKE
+        VeXOF_HashInitialize_TurboSHAKE256(&vexofInstance, 0x1F);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 200);
+        VeXOF_SqueezeBytes(&vexofInstance, output, 1361);
+        VeXOF_Export(&vexofInstance, exported);
+        testok &= VeXOF_Import(&restored, exported) == 0;
+        VeXOF_SqueezeBytes(&restored, output, 5000);
+        vexof_turbo_ref(pt_public_key_seed, 200, 136, 0x1F, prng_output_public, 6400);
+        testok &= memcmp((const uint8_t *)prng_output_public + 1361, output, 5000) == 0;
+
+        // Invalid data is rejected, including domain bytes the initializers do not accept
+        exported[7] = 0x80;
+        testok &= VeXOF_Import(&restored, exported) != 0;
+        exported[7] = 0x00;
+        testok &= VeXOF_Import(&restored, exported) != 0;
+        exported[7] = 0x7F;
+        testok &= VeXOF_Import(&restored, exported) == 0;
+        exported[15] = 1;
+        testok &= VeXOF_Import(&restored, exported) != 0;
+        exported[15] = 0;
+        exported[10] = 1;
+        testok &= VeXOF_Import(&restored, exported) != 0;
+        exported[4] = VEXOF_EXPORT_VERSION + 1;
+        testok &= VeXOF_Import(&restored, exported) != 0;
+
+        if (testok)
+        {
+            printf("Export test ok\n");
+        }
+        else
+        {
+            printf("Export test Failed\n");
+        }
+    }
+
+    // Test clones and forks
+    {
+        uint8_t *output = (uint8_t *)prng_output_public_c;
+        VeXOF_Instance vexofInstance, copies[3];
+
+        vexof(pt_public_key_seed, 96, prng_output_public, NUM_XOF_BYTES);
+        testok = 1;
+
+        // Forks of an absorbed prefix, each absorbing its own suffix
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 40);
+        for (int idx = 0; idx < 3; idx++)
+        {
+            VeXOF_Fork(&copies[idx], &vexofInstance);
+            VeXOF_HashUpdate(&copies[idx], (const uint8_t *)pt_public_key_seed + 40, 16 + 24 * idx);
+        }
+        for (int idx = 0; idx < 3; idx++)
+        {
+            vexof(pt_public_key_seed, 56 + 24 * idx, prng_output_public_c, 2000);
+            VeXOF_SqueezeBytes(&copies[idx], output + 2000, 2000);
+            testok &= memcmp(output, output + 2000, 2000) == 0;
+        }
+
+        // Forks and clones of a squeezing instance continue at its position
+        VeXOF_HashUpdate(&vexofInstance, (const uint8_t *)pt_public_key_seed + 40, 56);
+        VeXOF_SqueezeBytes(&vexofInstance, output, 1001);
+        VeXOF_Fork(&copies[0], &vexofInstance);
+        VeXOF_Clone(&copies[1], &vexofInstance);
+        VeXOF_Fork(&copies[2], &copies[0]);
+        for (int idx = 0; idx < 3; idx++)
+        {
+            VeXOF_SqueezeBytes(&copies[idx], output, 3000);
+            testok &= memcmp((const uint8_t *)prng_output_public + 1001, output, 3000) == 0;
+        }
+        VeXOF_SqueezeBytes(&vexofInstance, output, 3000);
+        testok &= memcmp((const uint8_t *)prng_output_public + 1001, output, 3000) == 0;
+
+        // A clone of a fork shares the same parent
+        VeXOF_Clone(&copies[1], &copies[0]);
+        VeXOF_SqueezeBytes(&copies[1], output, 3000);
+        testok &= memcmp((const uint8_t *)prng_output_public + 4001, output, 3000) == 0;
+
+        // Forks at block boundaries and within blocks and batches
+        const size_t fork_offsets[] = {0, 5, 168, 300, 1344, 1349, 2687};
+        size_t position = 0;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 96);
+        for (size_t idx = 0; idx < sizeof(fork_offsets) / sizeof(fork_offsets[0]); idx++)
+        {
+            VeXOF_SqueezeBytes(&vexofInstance, output, fork_offsets[idx] - position);
+            position = fork_offsets[idx];
+            VeXOF_Fork(&copies[0], &vexofInstance);
+            VeXOF_SqueezeBytes(&copies[0], output, 3);
+            VeXOF_SqueezeBytes(&copies[0], output + 3, 1997);
+            testok &= memcmp((const uint8_t *)prng_output_public + position, output, 2000) == 0;
+        }
+
+        if (testok)
+        {
+            printf("Clone test ok\n");
+        }
+        else
+        {
+            printf("Clone test Failed\n");
+        }
+    }
+
+    // Test multithreaded squeeze
+    {
+        vexof(pt_public_key_seed, 16, prng_output_public, NUM_XOF_BYTES);
+        memset(prng_output_public_c, 0, NUM_XOF_BYTES);
+
+        VeXOF_SetThreads(4, 0);
+
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+        VeXOF_SqueezeParallel(&vexofInstance, prng_output_public_c, 200);
+        VeXOF_SqueezeParallel(&vexofInstance, &prng_output_public_c[200 / 8], 20000);
+        VeXOF_Squeeze(&vexofInstance, &prng_output_public_c[20200 / 8], 8);
+        VeXOF_SqueezeParallel(&vexofInstance, &prng_output_public_c[20208 / 8], NUM_XOF_BYTES - 20208);
+
+        testok = memcmp(prng_output_public, prng_output_public_c, NUM_XOF_BYTES) == 0;
+
+        // With non-temporal stores
+        memset(prng_output_public_c, 0, NUM_XOF_BYTES);
+        VeXOF_SetStreaming(1);
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+        VeXOF_SqueezeParallel(&vexofInstance, prng_output_public_c, NUM_XOF_BYTES);
+        VeXOF_SetStreaming(0);
+        testok &= memcmp(prng_output_public, prng_output_public_c, NUM_XOF_BYTES) == 0;
+
+        // Requests above VEXOF_MAX_THREADS all select the largest pool
+        memset(prng_output_public_c, 0, NUM_XOF_BYTES);
+        testok &= VeXOF_SetThreads(VEXOF_MAX_THREADS + 1, 0) == 0;
+        testok &= VeXOF_SetThreads(2 * VEXOF_MAX_THREADS, 0) == 0;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+        VeXOF_SqueezeParallel(&vexofInstance, prng_output_public_c, NUM_XOF_BYTES);
+        testok &= memcmp(prng_output_public, prng_output_public_c, NUM_XOF_BYTES) == 0;
+        VeXOF_SetThreads(4, 0);
+
+        if (testok)
+        {
+            printf("Parallel squeeze test ok\n");
+        }
+        else
+        {
+            printf("Parallel squeeze test Failed\n");
+        }
+    }
+
+    // Test batch squeeze
+    {
+        const size_t seed_lens[] = {16, 0, 7, 32, 100, 151, 16, 48, 16, 13, 64};
+        const size_t out_lens[] = {168, 8, 100, 336, 1, 500, 0, 2000, 169, 168, 40};
+        enum { NUM_SEEDS = sizeof(seed_lens) / sizeof(seed_lens[0]) };
+        uint8_t seeds[NUM_SEEDS][200];
+        const uint8_t *seed_ptrs[NUM_SEEDS];
+        uint8_t *output_ptrs[NUM_SEEDS];
+        size_t offset = 0;
+
+        for (int idx = 0; idx < NUM_SEEDS; idx++)
+        {
+            for (int idx2 = 0; idx2 < 200; idx2++)
+                seeds[idx][idx2] = idx * 31 + idx2;
+            seed_ptrs[idx] = seeds[idx];
+            output_ptrs[idx] = (uint8_t *)prng_output_public + offset;
+            offset += out_lens[idx];
+        }
+        VeXOF_BatchSqueeze(seed_ptrs, seed_lens, output_ptrs, out_lens, NUM_SEEDS);
+
+        testok = 1;
+        for (int idx = 0; idx < NUM_SEEDS; idx++)
+        {
+            vexof_ref(seeds[idx], seed_lens[idx], prng_output_public_c, (out_lens[idx] + 63) / 64 * 64);
+            if (memcmp(output_ptrs[idx], prng_output_public_c, out_lens[idx]))
+            {
+                printf("Batch squeeze test Failed @ seed %d\n", idx);
+                testok = 0;
+            }
+        }
+
+        // Seeds longer than a block, absorbed from a copy of the common state
+        const size_t long_lens[] = {168, 1000, 20000, 159};
+        enum { NUM_LONG = sizeof(long_lens) / sizeof(long_lens[0]) };
+        const size_t long_out_lens[NUM_LONG] = {200, 168, 1344, 400};
+        uint8_t *long_seed = (uint8_t *)prng_output_public + 2 * NUM_XOF_BYTES;
+        const uint8_t *long_ptrs[NUM_LONG];
+        uint8_t *long_outputs[NUM_LONG];
+        for (int idx = 0; idx < 20000; idx++)
+            long_seed[idx] = idx * 13 + 5;
+        offset = 0;
+        for (int idx = 0; idx < NUM_LONG; idx++)
+        {
+            long_ptrs[idx] = long_seed + idx;
+            long_outputs[idx] = (uint8_t *)prng_output_public + offset;
+            offset += long_out_lens[idx];
+        }
+        VeXOF_BatchSqueeze(long_ptrs, long_lens, long_outputs, long_out_lens, NUM_LONG);
+        for (int idx = 0; idx < NUM_LONG; idx++)
+        {
+            vexof_ref(long_ptrs[idx], long_lens[idx], prng_output_public_c, (long_out_lens[idx] + 63) / 64 * 64);
+            if (memcmp(long_outputs[idx], prng_output_public_c, long_out_lens[idx]))
+            {
+                printf("Batch squeeze test Failed @ long seed %d\n", idx);
+                testok = 0;
+            }
+        }
+        if (testok)
+        {
+            printf("Batch squeeze test ok\n");
+        }
+    }
+
+    // Test batch squeeze of suffixes of a common prefix
+    {
+        const size_t suffix_lens[] = {0, 1, 7, 8, 50, 127, 136, 150, 290, 16};
+        const size_t out_lens[] = {168, 8, 100, 336, 1, 500, 169, 2000, 40, 0};
+        enum { NUM_SUFFIXES = sizeof(suffix_lens) / sizeof(suffix_lens[0]), PREFIX_BYTES = 200 };
+        uint8_t seed[PREFIX_BYTES + 300];
+        const uint8_t *suffix_ptrs[NUM_SUFFIXES];
+        uint8_t *output_ptrs[NUM_SUFFIXES];
+        size_t offset = 0;
+
+        for (int idx = 0; idx < PREFIX_BYTES + 300; idx++)
+            seed[idx] = idx * 7 + 3;
+        for (int idx = 0; idx < NUM_SUFFIXES; idx++)
+        {
+            suffix_ptrs[idx] = seed + PREFIX_BYTES;
+            output_ptrs[idx] = (uint8_t *)prng_output_public + offset;
+            offset += out_lens[idx];
+        }
+
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, seed, PREFIX_BYTES);
+        VeXOF_BatchSqueezeSuffixes(&vexofInstance, suffix_ptrs, suffix_lens, output_ptrs, out_lens, NUM_SUFFIXES);
+
+        testok = 1;
+        for (int idx = 0; idx < NUM_SUFFIXES; idx++)
+        {
+            vexof_ref(seed, PREFIX_BYTES + suffix_lens[idx], prng_output_public_c, (out_lens[idx] + 63) / 64 * 64);
+            if (memcmp(output_ptrs[idx], prng_output_public_c, out_lens[idx]))
+            {
+                printf("Suffix squeeze test Failed @ suffix %d\n", idx);
+                testok = 0;
+            }
+        }
+
+        // TurboSHAKE, for which the reference takes whole 8 byte words
+        const size_t turbo_lens[] = {0, 8, 96, 104, 400};
+        for (size_t idx = 0; idx < sizeof(turbo_lens) / sizeof(turbo_lens[0]); idx++)
+        {
+            VeXOF_HashInitialize_TurboSHAKE256(&vexofInstance, 0x1F);
+            VeXOF_HashUpdate(&vexofInstance, seed, 40);
+            const uint8_t *suffix = seed + 40;
+            uint8_t *output = (uint8_t *)prng_output_public;
+            size_t out_len = 1000;
+            VeXOF_BatchSqueezeSuffixes(&vexofInstance, &suffix, &turbo_lens[idx], &output, &out_len, 1);
+            vexof_turbo_ref(seed, 40 + turbo_lens[idx], 136, 0x1F, prng_output_public_c, 1024);
+            if (memcmp(output, prng_output_public_c, out_len))
+            {
+                printf("Suffix squeeze test Failed @ TurboSHAKE suffix %zu\n", idx);
+                testok = 0;
+            }
+        }
+        if (testok)
+        {
+            printf("Suffix squeeze test ok\n");
+        }
+    }
+
+    // Test labelled substreams against absorbing each label
+    {
+        const uint64_t labels[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 255, 0x0123456789abcdefULL};
+        const size_t lengths[] = {1, 100, 168, 500, 1344, 3000};
+        enum { NUM_LABELS = sizeof(labels) / sizeof(labels[0]) };
+        uint8_t *output_ptrs[NUM_LABELS];
+        uint8_t *output = (uint8_t *)prng_output_public_c;
+
+        // Common inputs with the block index in a lane, at any byte position, and without room for the padding,
+        // for the rates of SHAKE128 and TurboSHAKE256
+        const size_t seed_lens[2][4] = {{32, 13, 155, 166}, {32, 13, 123, 134}};
+
+        testok = 1;
+        for (int turbo = 0; turbo < 2; turbo++)
+            for (int seed = 0; seed < 4; seed++)
+                for (size_t idx = 0; idx < sizeof(lengths) / sizeof(lengths[0]); idx++)
+                {
+                    VeXOF_Instance vexofInstance, labelled;
+                    if (turbo)
+                        VeXOF_HashInitialize_TurboSHAKE256(&vexofInstance, 0x1F);
+                    else
+                        VeXOF_HashInitialize(&vexofInstance);
+                    VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, seed_lens[turbo][seed]);
+
+                    for (int label = 0; label < NUM_LABELS; label++)
+                        output_ptrs[label] = (uint8_t *)prng_output_public + label * lengths[idx];
+                    VeXOF_SqueezeLabels(&vexofInstance, labels, output_ptrs, lengths[idx], NUM_LABELS);
+
+                    for (int label = 0; label < NUM_LABELS; label++)
+                    {
+                        uint8_t encoded[8];
+                        for (int idx2 = 0; idx2 < 8; idx2++)
+                            encoded[idx2] = (uint8_t)(labels[label] >> (8 * idx2));
+                        VeXOF_Fork(&labelled, &vexofInstance);
+                        VeXOF_HashUpdate(&labelled, encoded, 8);
+                        VeXOF_SqueezeBytes(&labelled, output, lengths[idx]);
+                        if (memcmp(output_ptrs[label], output, lengths[idx]))
+                        {
+                            printf("Labels test Failed @ label %d, %zu bytes, seed %zu bytes\n", label, lengths[idx],
+                                   seed_lens[turbo][seed]);
+                            testok = 0;
+                        }
+                    }
+                }
+        if (testok)
+        {
+            printf("Labels test ok\n");
+        }
+    }
+
+    // Test interleaved order against known answers and reference
+    {
+        uint8_t *output = (uint8_t *)prng_output_public;
+        uint8_t *reference = (uint8_t *)prng_output_public_c;
+        const size_t seed_lens[] = {16, 13, 160};
+        testok = 1;
+
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+        VeXOF_SqueezeInterleaved(&vexofInstance, VEXOF_INTERLEAVED_VERSION, output, 2688);
+        testok &= hex_equal(output, "c4d13cf4dc98099844bfb31aad5c5c30495f28fc14df76065ea98e60dd6f3271");
+        testok &= hex_equal(output + 1984, "3956f61b66cc9201bfc5660a57b01593dcc7eca5c8fbd6f8bbee0248f0424a99");
+
+        VeXOF_HashInitialize_SHAKE256(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+        VeXOF_SqueezeInterleaved(&vexofInstance, VEXOF_INTERLEAVED_VERSION, output, 1088);
+        testok &= hex_equal(output, "fd16a2dc910efb560baf5e955b08896dba2e33bb7f6d7410ef8244f347f60e2e");
+
+        for (size_t idx = 0; idx < sizeof(seed_lens) / sizeof(seed_lens[0]); idx++)
+        {
+            Keccak_HashInstance hashInstance;
+            Keccak_HashInitialize_SHAKE128(&hashInstance);
+            Keccak_HashUpdate(&hashInstance, pt_public_key_seed, 8 * seed_lens[idx]);
+            VeXOF_Reference_Interleaved(&hashInstance, reference, NUM_XOF_BYTES);
+
+            memset(output, 0, NUM_XOF_BYTES);
+            VeXOF_HashInitialize(&vexofInstance);
+            VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, seed_lens[idx]);
+            VeXOF_SqueezeInterleaved(&vexofInstance, VEXOF_INTERLEAVED_VERSION, output, 5);
+            VeXOF_SqueezeInterleaved(&vexofInstance, VEXOF_INTERLEAVED_VERSION, output + 5, 3000);
+            // A fork continues at the position in the interleaved order
+            VeXOF_Instance fork;
+            VeXOF_Fork(&fork, &vexofInstance);
+            VeXOF_SqueezeInterleaved(&fork, VEXOF_INTERLEAVED_VERSION, output + 3005, 1339);
+            VeXOF_SqueezeInterleaved(&fork, VEXOF_INTERLEAVED_VERSION, output + 4344, NUM_XOF_BYTES - 4344);
+            if (memcmp(output, reference, NUM_XOF_BYTES))
+            {
+                printf("Interleaved test Failed @ seed %zu bytes\n", seed_lens[idx]);
+                testok = 0;
+            }
+        }
+
+        // TurboSHAKE, against the standard order
+        VeXOF_HashInitialize_TurboSHAKE128(&vexofInstance, 0x1F);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+        VeXOF_Squeeze(&vexofInstance, prng_output_public_c, 2 * 1344);
+        VeXOF_HashInitialize_TurboSHAKE128(&vexofInstance, 0x1F);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+        VeXOF_SqueezeInterleaved(&vexofInstance, VEXOF_INTERLEAVED_VERSION, output, 2 * 1344);
+        for (size_t index = 0; index < 2 * 1344; index += 8)
+        {
+            size_t group = index / 1344, lane = index % 1344 / 64, block = index % 64 / 8;
+            testok &= memcmp(output + index, reference + group * 1344 + block * 168 + lane * 8, 8) == 0;
+        }
+        // Random access does not use the position
+        VeXOF_SqueezeAt(&vexofInstance, 336, (uint64_t *)output, 504);
+        testok &= memcmp(output, reference + 336, 504) == 0;
+
+        if (testok)
+        {
+            printf("Interleaved test ok\n");
+        }
+        else
+        {
+            printf("Interleaved test Failed\n");
+        }
+    }
+
+    // Test SHAKE256 against reference
+    {
+        vexof256_ref(pt_public_key_seed, 16, prng_output_public_c, NUM_XOF_BYTES);
+        memset(prng_output_public, 0, NUM_XOF_BYTES);
+
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize_SHAKE256(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+        VeXOF_Squeeze(&vexofInstance, prng_output_public, 1088);
+        VeXOF_Squeeze(&vexofInstance, &prng_output_public[1088 / 8], 136);
+        VeXOF_Squeeze(&vexofInstance, &prng_output_public[1224 / 8], NUM_XOF_BYTES - 1224);
+
+        testok = memcmp(prng_output_public, prng_output_public_c, NUM_XOF_BYTES) == 0;
+
+        const size_t offsets[] = {0, 128, 136, 1088, 5000};
+        for (size_t idx = 0; idx < sizeof(offsets) / sizeof(offsets[0]); idx++)
+        {
+            memset(prng_output_public, 0, 2000);
+            VeXOF_SqueezeAt(&vexofInstance, offsets[idx], prng_output_public, 2000);
+            if (memcmp(prng_output_public, &prng_output_public_c[offsets[idx] / 8], 2000))
+                testok = 0;
+        }
+        if (testok)
+        {
+            printf("SHAKE256 test ok\n");
+        }
+        else
+        {
+            printf("SHAKE256 test Failed\n");
+        }
+    }
+
+    // Test TurboSHAKE against known answers and reference
+    {
+        testok = 1;
+
+        // TurboSHAKE128 of the empty message, RFC 9861
+        uint8_t turbo[32];
+        KeccakWidth1600_12rounds_Sponge(1344, 256, pt_public_key_seed, 0, 0x1F, turbo, 32);
+        testok &= hex_equal(turbo, "1e415f1c5983aff2169217277d17bb538cd945a397ddec541f1ce41af2c1b74c");
+
+        vexof_turbo(pt_public_key_seed, 16, 168, 0x1F, prng_output_public, 1680);
+        testok &= hex_equal(prng_output_public, "98ad73c5dd45361741d3bba76b724a67d65d1b7d47de533cc1086c8bfd8faf76");
+        testok &= hex_equal(&prng_output_public[1512 / 8], "eebb2b984d64c9881a1ee91d4d709f96571bea2f7902c65384c81e03c9ad5361");
+        vexof_turbo(pt_public_key_seed, 16, 168, 0x0B, prng_output_public, 64);
+        testok &= hex_equal(prng_output_public, "dddedad24d01c4b2db55bc3b7bf0521d5486e1271d0ca98c31f06e4dc28cc493");
+        vexof_turbo(pt_public_key_seed, 16, 136, 0x1F, prng_output_public, 1360);
+        testok &= hex_equal(prng_output_public, "45631c379f8eee57c35e715066b984ed0ac93ce177e804fe65d46193f8a3e674");
+        testok &= hex_equal(&prng_output_public[1224 / 8], "d638f506f9f0b42ef830e985e0cdaeb1a0cf26276d731ef9fcf9a9aecbc86a39");
+
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize_TurboSHAKE128(&vexofInstance, 0x1F);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 96);
+        VeXOF_Squeeze(&vexofInstance, prng_output_public, 1344);
+        VeXOF_Squeeze(&vexofInstance, &prng_output_public[1344 / 8], 8);
+        VeXOF_Squeeze(&vexofInstance, &prng_output_public[1352 / 8], NUM_XOF_BYTES - 1352);
+        vexof_turbo_ref(pt_public_key_seed, 96, 168, 0x1F, prng_output_public_c, NUM_XOF_BYTES);
+        testok &= memcmp(prng_output_public, prng_output_public_c, NUM_XOF_BYTES) == 0;
+
+        VeXOF_HashInitialize_TurboSHAKE256(&vexofInstance, 0x1F);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 200);
+        VeXOF_SqueezeAt(&vexofInstance, 1360, prng_output_public, 5000);
+        vexof_turbo_ref(pt_public_key_seed, 200, 136, 0x1F, prng_output_public_c, 6400);
+        testok &= memcmp(prng_output_public, &prng_output_public_c[1360 / 8], 5000) == 0;
+
+        if (testok)
+        {
+            printf("TurboSHAKE test ok\n");
+        }
+        else
+        {
+            printf("TurboSHAKE test Failed\n");
+        }
+    }
+
+    // Test all backends supported by the CPU
+    {
+        const char *names[] = {"scalar", "times4-avx2", "times4-avx512", "times8-avx512"};
+        vexof_ref(pt_public_key_seed, 16, prng_output_public_c, NUM_XOF_BYTES);
+        vexof256_ref(pt_public_key_seed, 16, &prng_output_public_c[NUM_XOF_BYTES / 8], NUM_XOF_BYTES);
+        vexof_turbo_ref(pt_public_key_seed, 16, 168, 0x1F, &prng_output_public_c[2 * NUM_XOF_BYTES / 8], NUM_XOF_BYTES);
+
+        testok = 1;
+        for (size_t idx = 0; idx < sizeof(names) / sizeof(names[0]); idx++)
+        {
+            if (VeXOF_SetBackend(names[idx]))
+            {
+                printf("Backend %s not supported\n", names[idx]);
+                continue;
+            }
+            memset(prng_output_public, 0, NUM_XOF_BYTES);
+
+            VeXOF_Instance vexofInstance;
+            VeXOF_HashInitialize(&vexofInstance);
+            VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+            VeXOF_Squeeze(&vexofInstance, prng_output_public, 1344);
+            VeXOF_Squeeze(&vexofInstance, &prng_output_public[1344 / 8], 8);
+            VeXOF_Squeeze(&vexofInstance, &prng_output_public[1352 / 8], NUM_XOF_BYTES - 1352);
+            vexof256(pt_public_key_seed, 16, &prng_output_public[NUM_XOF_BYTES / 8], NUM_XOF_BYTES);
+            vexof_turbo(pt_public_key_seed, 16, 168, 0x1F, &prng_output_public[2 * NUM_XOF_BYTES / 8], NUM_XOF_BYTES);
+
+            if (memcmp(prng_output_public, prng_output_public_c, 3 * NUM_XOF_BYTES))
+            {
+                printf("Backend test Failed for %s\n", names[idx]);
+                testok = 0;
+            }
+        }
+        VeXOF_SetBackend(NULL);
+        if (testok)
+        {
+            printf("Backend test ok (default %s)\n", VeXOF_GetBackend());
+        }
+    }
+
+    // Report timings
+    printf("\nXKCP and VeXOF compared to OpenSSL for %d bytes (%d times)\n", NUM_XOF_BYTES, TEST_NUM);
+
+    for (int count = 0; count < TEST_NUM; count++)
+    {
+        test_cycles[count] = ticks();
+        pt_public_key_seed[0] = count % 256;
+        pt_public_key_seed[1] = count / 256;
+        hash_aes128(pt_public_key_seed, (uint8_t *)prng_output_public);
+    }
+    print_results("AES:\t", test_cycles, TEST_NUM, NUM_XOF_BYTES);
+
+    for (int count = 0; count < TEST_NUM; count++)
+    {
+        test_cycles[count] = ticks();
+        shake128(pt_public_key_seed, 16, (uint8_t *)prng_output_public, NUM_XOF_BYTES);
+    }
+    print_results("openssl:", test_cycles, TEST_NUM, NUM_XOF_BYTES);
+
+    for (int count = 0; count < TEST_NUM; count++)
+    {
+        test_cycles[count] = ticks();
+        pt_public_key_seed[0] = count % 256;
+        pt_public_key_seed[1] = count / 256;
+        xkcp(pt_public_key_seed, 16, (uint8_t *)prng_output_public, NUM_XOF_BYTES);
+    }
+    print_results("XKCP:\t", test_cycles, TEST_NUM, NUM_XOF_BYTES);
+
+    memset(prng_output_public, 0, NUM_XOF_BYTES);
+    for (int count = 0; count < TEST_NUM; count++)
+    {
+        test_cycles[count] = ticks();
+        pt_public_key_seed[0] = count % 256;
+        pt_public_key_seed[1] = count / 256;
+        vexof(pt_public_key_seed, 16, prng_output_public, NUM_XOF_BYTES);
+    }
+    print_results("VeXOF:\t", test_cycles, TEST_NUM, NUM_XOF_BYTES);
+
+    for (int count = 0; count < TEST_NUM; count++)
+    {
+        test_cycles[count] = ticks();
+        pt_public_key_seed[0] = count % 256;
+        pt_public_key_seed[1] = count / 256;
+        vexof_ref(pt_public_key_seed, 16, prng_output_public_c, NUM_XOF_BYTES);
+    }
+    print_results("Reference:", test_cycles, TEST_NUM, NUM_XOF_BYTES);
+
+    printf("\nXKCP and VeXOF based on SHAKE256 for %d bytes (%d times)\n", NUM_XOF_BYTES, TEST_NUM);
+
+    for (int count = 0; count < TEST_NUM; count++)
+    {
+        test_cycles[count] = ticks();
+        pt_public_key_seed[0] = count % 256;
+        pt_public_key_seed[1] = count / 256;
+        xkcp256(pt_public_key_seed, 16, (uint8_t *)prng_output_public, NUM_XOF_BYTES);
+    }
+    print_results("XKCP:\t", test_cycles, TEST_NUM, NUM_XOF_BYTES);
+
+    for (int count = 0; count < TEST_NUM; count++)
+    {
+        test_cycles[count] = ticks();
+        pt_public_key_seed[0] = count % 256;
+        pt_public_key_seed[1] = count / 256;
+        vexof256(pt_public_key_seed, 16, prng_output_public, NUM_XOF_BYTES);
+    }
+    print_results("VeXOF:\t", test_cycles, TEST_NUM, NUM_XOF_BYTES);
+
+    printf("\nVeXOF based on TurboSHAKE128 and TurboSHAKE256 for %d bytes (%d times)\n", NUM_XOF_BYTES, TEST_NUM);
+
+    for (int count = 0; count < TEST_NUM; count++)
+    {
+        test_cycles[count] = ticks();
+        pt_public_key_seed[0] = count % 256;
+        pt_public_key_seed[1] = count / 256;
+        vexof_turbo(pt_public_key_seed, 16, 168, 0x1F, prng_output_public, NUM_XOF_BYTES);
+    }
+    print_results("Turbo128:", test_cycles, TEST_NUM, NUM_XOF_BYTES);
+
+    for (int count = 0; count < TEST_NUM; count++)
+    {
+        test_cycles[count] = ticks();
+        pt_public_key_seed[0] = count % 256;
+        pt_public_key_seed[1] = count / 256;
+        vexof_turbo(pt_public_key_seed, 16, 136, 0x1F, prng_output_public, NUM_XOF_BYTES);
+    }
+    print_results("Turbo256:", test_cycles, TEST_NUM, NUM_XOF_BYTES);
+
+    // Compare many short outputs
+    {
+        enum { NUM_SEEDS = 32, SEED_BYTES = 32, OUTPUT_BYTES = 336 };
+        const uint8_t *seed_ptrs[NUM_SEEDS];
+        uint8_t *output_ptrs[NUM_SEEDS];
+        size_t seed_lens[NUM_SEEDS], out_lens[NUM_SEEDS];
+
+        for (int idx = 0; idx < NUM_SEEDS; idx++)
+        {
+            seed_ptrs[idx] = (uint8_t *)prng_output_public_c + idx * SEED_BYTES;
+            output_ptrs[idx] = (uint8_t *)prng_output_public + idx * OUTPUT_BYTES;
+            seed_lens[idx] = SEED_BYTES;
+            out_lens[idx] = OUTPUT_BYTES;
+        }
+
+        printf("\n%d seeds of %d bytes, %d bytes output each\n", NUM_SEEDS, SEED_BYTES, OUTPUT_BYTES);
+
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            prng_output_public_c[0] = count;
+            for (int idx = 0; idx < NUM_SEEDS; idx++)
+                vexof(seed_ptrs[idx], SEED_BYTES, (uint64_t *)output_ptrs[idx], OUTPUT_BYTES);
+        }
+        print_results("VeXOF:\t", test_cycles, TEST_NUM, NUM_SEEDS * OUTPUT_BYTES);
+
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            prng_output_public_c[0] = count;
+            VeXOF_BatchSqueeze(seed_ptrs, seed_lens, output_ptrs, out_lens, NUM_SEEDS);
+        }
+        print_results("Batch:\t", test_cycles, TEST_NUM, NUM_SEEDS * OUTPUT_BYTES);
+    }
+
+    // Compare seeds with a common prefix
+    {
+        enum { NUM_SEEDS = 32, PREFIX_BYTES = 400, SUFFIX_BYTES = 8, OUTPUT_BYTES = 336 };
+        uint8_t seeds[NUM_SEEDS][PREFIX_BYTES + SUFFIX_BYTES];
+        const uint8_t *seed_ptrs[NUM_SEEDS], *suffix_ptrs[NUM_SEEDS];
+        uint8_t *output_ptrs[NUM_SEEDS];
+        size_t seed_lens[NUM_SEEDS], suffix_lens[NUM_SEEDS], out_lens[NUM_SEEDS];
+
+        for (int idx = 0; idx < NUM_SEEDS; idx++)
+        {
+            memset(seeds[idx], 0x5A, PREFIX_BYTES);
+            memset(seeds[idx] + PREFIX_BYTES, idx, SUFFIX_BYTES);
+            seed_ptrs[idx] = seeds[idx];
+            suffix_ptrs[idx] = seeds[idx] + PREFIX_BYTES;
+            output_ptrs[idx] = (uint8_t *)prng_output_public + idx * OUTPUT_BYTES;
+            seed_lens[idx] = PREFIX_BYTES + SUFFIX_BYTES;
+            suffix_lens[idx] = SUFFIX_BYTES;
+            out_lens[idx] = OUTPUT_BYTES;
+        }
+
+        printf("\n%d seeds of a %d byte prefix and a %d byte suffix, %d bytes output each\n", NUM_SEEDS,
+               PREFIX_BYTES, SUFFIX_BYTES, OUTPUT_BYTES);
+
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            seeds[0][0] = count % 256;
+            VeXOF_BatchSqueeze(seed_ptrs, seed_lens, output_ptrs, out_lens, NUM_SEEDS);
+        }
+        print_results("Batch:\t", test_cycles, TEST_NUM, NUM_SEEDS * OUTPUT_BYTES);
+
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            seeds[0][0] = count % 256;
+            VeXOF_Instance vexofInstance;
+            VeXOF_HashInitialize(&vexofInstance);
+            VeXOF_HashUpdate(&vexofInstance, seeds[0], PREFIX_BYTES);
+            VeXOF_BatchSqueezeSuffixes(&vexofInstance, suffix_ptrs, suffix_lens, output_ptrs, out_lens, NUM_SEEDS);
+        }
+        print_results("Suffixes:", test_cycles, TEST_NUM, NUM_SEEDS * OUTPUT_BYTES);
+    }
+
+    // Compare substreams of one seed
+    {
+        enum { NUM_LABELS = 32, OUTPUT_BYTES = 336 };
+        uint64_t labels[NUM_LABELS];
+        uint8_t *output_ptrs[NUM_LABELS];
+
+        for (int idx = 0; idx < NUM_LABELS; idx++)
+        {
+            labels[idx] = idx;
+            output_ptrs[idx] = (uint8_t *)prng_output_public + idx * OUTPUT_BYTES;
+        }
+
+        printf("\n%d labels of one seed, %d bytes output each\n", NUM_LABELS, OUTPUT_BYTES);
+
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            pt_public_key_seed[0] = count % 256;
+            for (int idx = 0; idx < NUM_LABELS; idx++)
+            {
+                VeXOF_Instance vexofInstance;
+                VeXOF_HashInitialize(&vexofInstance);
+                VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 32);
+                VeXOF_HashUpdate(&vexofInstance, (const uint8_t *)&labels[idx], 8);
+                VeXOF_SqueezeBytes(&vexofInstance, output_ptrs[idx], OUTPUT_BYTES);
+            }
+        }
+        print_results("VeXOF:\t", test_cycles, TEST_NUM, NUM_LABELS * OUTPUT_BYTES);
+
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            pt_public_key_seed[0] = count % 256;
+            VeXOF_Instance vexofInstance;
+            VeXOF_HashInitialize(&vexofInstance);
+            VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 32);
+            VeXOF_SqueezeLabels(&vexofInstance, labels, output_ptrs, OUTPUT_BYTES, NUM_LABELS);
+        }
+        print_results("Labels:\t", test_cycles, TEST_NUM, NUM_LABELS * OUTPUT_BYTES);
+    }
+
+    // Compare sparse block fetches
+    {
+        enum { NUM_BLOCKS = 64 };
+        uint64_t indices[NUM_BLOCKS];
+        uint8_t *output = (uint8_t *)prng_output_public;
+
+        for (int idx = 0; idx < NUM_BLOCKS; idx++)
+            indices[idx] = (uint64_t)idx * 1009 % 4096;
+
+        printf("\n%d scattered blocks of 168 bytes\n", NUM_BLOCKS);
+
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            pt_public_key_seed[0] = count % 256;
+            VeXOF_Instance vexofInstance;
+            VeXOF_HashInitialize(&vexofInstance);
+            VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 32);
+            for (int idx = 0; idx < NUM_BLOCKS; idx++)
+                VeXOF_SqueezeAt(&vexofInstance, indices[idx] * 168, (uint64_t *)(output + idx * 168), 168);
+        }
+        print_results("SqueezeAt:", test_cycles, TEST_NUM, NUM_BLOCKS * 168);
+
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            pt_public_key_seed[0] = count % 256;
+            VeXOF_Instance vexofInstance;
+            VeXOF_HashInitialize(&vexofInstance);
+            VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 32);
+            VeXOF_SqueezeBlocks(&vexofInstance, indices, NUM_BLOCKS, output);
+        }
+        print_results("Blocks:\t", test_cycles, TEST_NUM, NUM_BLOCKS * 168);
+
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            pt_public_key_seed[0] = count % 256;
+            VeXOF_Instance vexofInstance;
+            VeXOF_HashInitialize(&vexofInstance);
+            VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 13);
+            VeXOF_SqueezeBlocks(&vexofInstance, indices, NUM_BLOCKS, output);
+        }
+        print_results("Blocks, 13 byte seed:", test_cycles, TEST_NUM, NUM_BLOCKS * 168);
+    }
+
+    // Compare word at a time consumers
+    {
+        enum { NUM_WORDS = 4096 };
+        uint64_t sum = 0;
+
+        printf("\n%d words of 8 bytes, one at a time\n", NUM_WORDS);
+
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            pt_public_key_seed[0] = count % 256;
+            pt_public_key_seed[1] = count / 256;
+            VeXOF_Instance vexofInstance;
+            VeXOF_HashInitialize(&vexofInstance);
+            VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+            for (int idx = 0; idx < NUM_WORDS; idx++)
+            {
+                uint64_t word;
+                VeXOF_Squeeze(&vexofInstance, &word, 8);
+                sum += word;
+            }
+        }
+        print_results("Squeeze:", test_cycles, TEST_NUM, 8 * NUM_WORDS);
+
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            pt_public_key_seed[0] = count % 256;
+            pt_public_key_seed[1] = count / 256;
+            VeXOF_Instance vexofInstance;
+            VeXOF_HashInitialize(&vexofInstance);
+            VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+            for (int idx = 0; idx < NUM_WORDS; idx++)
+                sum += VeXOF_Next64(&vexofInstance);
+        }
+        print_results("Next64:\t", test_cycles, TEST_NUM, 8 * NUM_WORDS);
+        prng_output_public[0] = sum;
+    }
+
+    // Compare XOR of the output into data
+    {
+        enum { XOR_BYTES = 1 << 20 };
+        uint8_t *data = (uint8_t *)prng_output_public;
+        uint8_t *keystream = (uint8_t *)prng_output_public_c;
+
+        printf("\nXOR output into %d bytes\n", XOR_BYTES);
+
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            VeXOF_SqueezeBytes(&vexofInstance, keystream, XOR_BYTES);
+            for (int idx = 0; idx < XOR_BYTES; idx++)
+                data[idx] ^= keystream[idx];
+        }
+        print_results("Squeeze:", test_cycles, TEST_NUM, XOR_BYTES);
+
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            VeXOF_SqueezeXor(&vexofInstance, data, data, XOR_BYTES);
+        }
+        print_results("Xor:\t", test_cycles, TEST_NUM, XOR_BYTES);
+    }
+
+    // Compare standard and interleaved order
+    {
+        printf("\nInterleaved order, %d bytes output\n", NUM_XOF_BYTES);
+
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            VeXOF_Squeeze(&vexofInstance, prng_output_public, NUM_XOF_BYTES);
+        }
+        print_results("Squeeze:", test_cycles, TEST_NUM, NUM_XOF_BYTES);
+
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            VeXOF_SqueezeInterleaved(&vexofInstance, VEXOF_INTERLEAVED_VERSION, (uint8_t *)prng_output_public,
+                                     NUM_XOF_BYTES);
+        }
+        print_results("Interleaved:", test_cycles, TEST_NUM, NUM_XOF_BYTES);
+    }
+
+    // Compare stores through the cache with non-temporal stores, for output that does not fit in the cache
+    {
+        enum { STREAM_BYTES = 256 << 20, CHUNK_BYTES = 4 << 20 };
+        uint8_t *stream_output = malloc(STREAM_BYTES);
+        size_t offset = 0;
+
+        printf("\n%d MB output in chunks of %d MB\n", STREAM_BYTES >> 20, CHUNK_BYTES >> 20);
+
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, pt_public_key_seed, 16);
+        memset(stream_output, 0, STREAM_BYTES);
+
+        VeXOF_SetStreaming(SIZE_MAX);
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            VeXOF_SqueezeBytes(&vexofInstance, stream_output + offset, CHUNK_BYTES);
+            offset = (offset + CHUNK_BYTES) % STREAM_BYTES;
+        }
+        print_results("Cached:\t", test_cycles, TEST_NUM, CHUNK_BYTES);
+
+        VeXOF_SetStreaming(1);
+        for (int count = 0; count < TEST_NUM; count++)
+        {
+            test_cycles[count] = ticks();
+            VeXOF_SqueezeBytes(&vexofInstance, stream_output + offset, CHUNK_BYTES);
+            offset = (offset + CHUNK_BYTES) % STREAM_BYTES;
+        }
+        print_results("Streamed:", test_cycles, TEST_NUM, CHUNK_BYTES);
+
+        VeXOF_SetStreaming(0);
+        free(stream_output);
+    }
+
+    // Compare outputs of one block from seeds near the longest that fits in it
+    {
+        const int sizes[] = {1, 32, 100, 168};
+        enum { SEED_BYTES = 159 };
+        uint8_t seed[SEED_BYTES] = {0};
+
+        for (size_t idx = 0; idx < sizeof(sizes) / sizeof(sizes[0]); idx++)
+        {
+            int bytes = sizes[idx];
+            printf("\nXOF squeeze %d bytes, %d byte seed\n", bytes, SEED_BYTES);
+
+            for (int count = 0; count < TEST_NUM; count++)
+            {
+                test_cycles[count] = ticks();
+                seed[0] = count % 256;
+                seed[1] = count / 256;
+                xkcp(seed, SEED_BYTES, (uint8_t *)prng_output_public_c, bytes);
+            }
+            print_results("XKCP\t", test_cycles, TEST_NUM, bytes);
+
+            for (int count = 0; count < TEST_NUM; count++)
+            {
+                test_cycles[count] = ticks();
+                seed[0] = count % 256;
+                seed[1] = count / 256;
+                vexof(seed, SEED_BYTES, prng_output_public, bytes);
+            }
+            print_results("VeXOF:\t", test_cycles, TEST_NUM, bytes);
+        }
     }
-    print_results("Reference:", test_cycles, TEST_NUM, NUM_XOF_BYTES);
 
     // Compare various sizes
     for (int bytes = 64; bytes < 10000; bytes *= 2)
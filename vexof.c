@@ -7,6 +7,9 @@
  * https://github.com/vacuas/vexof
  */
 
+// Required for pthreads and sysconf with -std=c11
+#define _POSIX_C_SOURCE 200809L
+
 #include "vexof.h"
 
 #ifndef DEBUG
@@ -24,152 +27,1823 @@
 #if KeccakP1600_stateSizeInBytes != 200
 #error "KeccakP1600_stateSizeInBytes must be 200"
 #endif
+#ifdef VEXOF_COMPACT
+_Static_assert(sizeof(VeXOF_Instance) <= 768, "Compact VeXOF instances must stay small");
+#endif
 
 #include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// The SIMD backends are only built for x86-64, other platforms have the scalar backend
+#if defined(__x86_64__)
+#include <emmintrin.h>
 
-#if PARALLELISM == 8
-#include "FIPS202-timesx/KeccakP-1600-times8-SnP.h"
-#elif PARALLELISM == 4
 #include "FIPS202-timesx/KeccakP-1600-times4-SnP.h"
+#include "FIPS202-timesx/KeccakP-1600-times4-SIMD512-SnP.h"
+#include "FIPS202-timesx/KeccakP-1600-times8-SnP.h"
+#endif
+
+/**
+ * Implementation of the parallel permutations, selected at runtime.
+ */
+typedef struct VeXOF_Backend
+{
+    const char *name;
+    unsigned int parallelism;
+    int narrower;
+    int (*supported)(void);
+    void (*overwrite_bytes)(void *states, unsigned int instance, const unsigned char *data, unsigned int offset, unsigned int length);
+    void (*add_bytes)(void *states, unsigned int instance, const unsigned char *data, unsigned int offset, unsigned int length);
+    void (*extract_bytes)(const void *states, unsigned int instance, unsigned char *data, unsigned int offset, unsigned int length);
+    void (*permute_24rounds)(void *states);
+    void (*permute_12rounds)(void *states);
+    /* Only the first 21 lanes of the last round are computed, lane_count must be at most 21 */
+    void (*squeeze_blocks)(const void *state, unsigned int lane_count, unsigned int counter_lane, uint64_t first_block, unsigned char *data, size_t num_batches);
+    void (*squeeze_blocks_12rounds)(const void *state, unsigned int lane_count, unsigned int counter_lane, uint64_t first_block, unsigned char *data, size_t num_batches);
+    /* The same blocks in groups of 8, lane by lane, as in VeXOF_SqueezeInterleaved */
+    void (*squeeze_interleaved)(const void *state, unsigned int lane_count, unsigned int counter_lane, uint64_t first_block, unsigned char *data, size_t num_batches);
+    void (*squeeze_interleaved_12rounds)(const void *state, unsigned int lane_count, unsigned int counter_lane, uint64_t first_block, unsigned char *data, size_t num_batches);
+} VeXOF_Backend;
+
+static void scalar_overwrite_bytes(void *states, unsigned int instance, const unsigned char *data, unsigned int offset, unsigned int length)
+{
+    (void)instance;
+    KeccakP1600_OverwriteBytes(states, data, offset, length);
+}
+
+static void scalar_add_bytes(void *states, unsigned int instance, const unsigned char *data, unsigned int offset, unsigned int length)
+{
+    (void)instance;
+    KeccakP1600_AddBytes(states, data, offset, length);
+}
+
+static void scalar_extract_bytes(const void *states, unsigned int instance, unsigned char *data, unsigned int offset, unsigned int length)
+{
+    (void)instance;
+    KeccakP1600_ExtractBytes(states, data, offset, length);
+}
+
+static int cpu_any(void)
+{
+    return 1;
+}
+
+#if defined(__x86_64__)
+static int cpu_avx2(void)
+{
+    return __builtin_cpu_supports("avx2");
+}
+
+static int cpu_avx512vl(void)
+{
+    return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl");
+}
+
+static int cpu_avx512(void)
+{
+    return __builtin_cpu_supports("avx512f");
+}
+#endif
+
+enum
+{
+#if defined(__x86_64__)
+    BACKEND_TIMES8_AVX512,
+    BACKEND_TIMES4_AVX2,
+    BACKEND_TIMES4_AVX512,
+#endif
+    BACKEND_SCALAR,
+    NUM_BACKENDS
+};
+
+// In order of preference. Short squeezes use the narrower backend if that covers the blocks.
+static const VeXOF_Backend backends[NUM_BACKENDS] = {
+#if defined(__x86_64__)
+    [BACKEND_TIMES8_AVX512] = {"times8-avx512", 8, BACKEND_TIMES4_AVX512, cpu_avx512,
+                               KeccakP1600times8_OverwriteBytes, KeccakP1600times8_AddBytes,
+                               KeccakP1600times8_ExtractBytes, KeccakP1600times8_PermuteAll_24rounds, KeccakP1600times8_PermuteAll_12rounds,
+                               KeccakP1600times8_SqueezeBlocks, KeccakP1600times8_12rounds_SqueezeBlocks,
+                               KeccakP1600times8_SqueezeBlocksInterleaved, KeccakP1600times8_12rounds_SqueezeBlocksInterleaved},
+    [BACKEND_TIMES4_AVX2] = {"times4-avx2", 4, BACKEND_SCALAR, cpu_avx2,
+                             KeccakP1600times4_OverwriteBytes, KeccakP1600times4_AddBytes,
+                             KeccakP1600times4_ExtractBytes, KeccakP1600times4_PermuteAll_24rounds, KeccakP1600times4_PermuteAll_12rounds,
+                             KeccakP1600times4_SqueezeBlocks, KeccakP1600times4_12rounds_SqueezeBlocks,
+                             KeccakP1600times4_SqueezeBlocksInterleaved, KeccakP1600times4_12rounds_SqueezeBlocksInterleaved},
+    [BACKEND_TIMES4_AVX512] = {"times4-avx512", 4, BACKEND_SCALAR, cpu_avx512vl,
+                               KeccakP1600times4x512_OverwriteBytes, KeccakP1600times4x512_AddBytes,
+                               KeccakP1600times4x512_ExtractBytes, KeccakP1600times4x512_PermuteAll_24rounds, KeccakP1600times4x512_PermuteAll_12rounds,
+                               KeccakP1600times4x512_SqueezeBlocks, KeccakP1600times4x512_12rounds_SqueezeBlocks,
+                               KeccakP1600times4x512_SqueezeBlocksInterleaved, KeccakP1600times4x512_12rounds_SqueezeBlocksInterleaved},
 #endif
+    [BACKEND_SCALAR] = {"scalar", 1, -1, cpu_any,
+                        scalar_overwrite_bytes, scalar_add_bytes,
+                        scalar_extract_bytes, KeccakP1600_Permute_24rounds, KeccakP1600_Permute_12rounds,
+                        KeccakP1600_SqueezeBlocks, KeccakP1600_12rounds_SqueezeBlocks,
+                        KeccakP1600_SqueezeBlocksInterleaved, KeccakP1600_12rounds_SqueezeBlocksInterleaved},
+};
+
+static const VeXOF_Backend *selected_backend;
+static pthread_once_t backend_once = PTHREAD_ONCE_INIT;
+
+static const VeXOF_Backend *find_backend(const char *name)
+{
+    for (size_t idx = 0; idx < NUM_BACKENDS; idx++)
+        if (!strcmp(backends[idx].name, name) && backends[idx].supported())
+            return &backends[idx];
+    return NULL;
+}
+
+/**
+ * The default backend: the environment override if usable, otherwise the first supported.
+ */
+static const VeXOF_Backend *default_backend(void)
+{
+    const VeXOF_Backend *backend = NULL;
+    const char *name = getenv("VEXOF_BACKEND");
+    if (name)
+        backend = find_backend(name);
+
+    for (size_t idx = 0; !backend; idx++)
+        if (backends[idx].supported())
+            backend = &backends[idx];
+    return backend;
+}
+
+static void select_backend(void)
+{
+    selected_backend = default_backend();
+}
+
+static const VeXOF_Backend *get_backend(void)
+{
+    pthread_once(&backend_once, select_backend);
+    return selected_backend;
+}
+
+/**
+ * The narrowest supported backend, starting from backend, that generates num_blocks blocks in one batch.
+ */
+static const VeXOF_Backend *narrow_backend(const VeXOF_Backend *backend, size_t num_blocks)
+{
+    for (int idx = backend->narrower; idx >= 0 && backends[idx].parallelism >= num_blocks; idx = backends[idx].narrower)
+        if (backends[idx].supported())
+            backend = &backends[idx];
+    return backend;
+}
+
+/**
+ * Select the backend for subsequent squeezes.
+ */
+int VeXOF_SetBackend(const char *name)
+{
+    get_backend();
+
+    // Squeezes in other threads may read the selected backend at any time, so it is never NULL
+    if (!name)
+    {
+        selected_backend = default_backend();
+        return 0;
+    }
+
+    // Not an error in debug builds either: which names are supported depends on the platform and CPU
+    const VeXOF_Backend *backend = find_backend(name);
+    if (!backend)
+        return 1;
+    selected_backend = backend;
+
+    return 0;
+}
+
+/**
+ * Name of the selected backend.
+ */
+const char *VeXOF_GetBackend(void)
+{
+    return get_backend()->name;
+}
+
+/**
+ * Switch to absorbing. The buffer is emptied, so that VeXOF_Next64 takes its slow path to prepare the squeeze.
+ */
+static void start_absorbing(VeXOF_Instance *vexof_instance)
+{
+    vexof_instance->shared = NULL;
+    vexof_instance->squeezing = 0;
+    vexof_instance->interleaved = 0;
+    vexof_instance->buffer_pos = 0;
+    vexof_instance->buffer_len = 0;
+}
 
 /**
  * Create VeXOF instance
  */
 int VeXOF_HashInitialize(VeXOF_Instance *vexof_instance)
 {
-    vexof_instance->squeezing = 0;
+    start_absorbing(vexof_instance);
+    vexof_instance->rounds = 24;
     return Keccak_HashInitialize_SHAKE128(&vexof_instance->keccak_instance);
 }
 
+/**
+ * Create VeXOF instance based on SHAKE256
+ */
+int VeXOF_HashInitialize_SHAKE256(VeXOF_Instance *vexof_instance)
+{
+    start_absorbing(vexof_instance);
+    vexof_instance->rounds = 24;
+    return Keccak_HashInitialize_SHAKE256(&vexof_instance->keccak_instance);
+}
+
+/**
+ * Create VeXOF instance based on TurboSHAKE128
+ */
+int VeXOF_HashInitialize_TurboSHAKE128(VeXOF_Instance *vexof_instance, uint8_t domain)
+{
+    check(domain >= 0x01 && domain <= 0x7F);
+    start_absorbing(vexof_instance);
+    vexof_instance->rounds = 12;
+    return Keccak_HashInitialize(&vexof_instance->keccak_instance, 1344, 256, 0, domain);
+}
+
+/**
+ * Create VeXOF instance based on TurboSHAKE256
+ */
+int VeXOF_HashInitialize_TurboSHAKE256(VeXOF_Instance *vexof_instance, uint8_t domain)
+{
+    check(domain >= 0x01 && domain <= 0x7F);
+    start_absorbing(vexof_instance);
+    vexof_instance->rounds = 12;
+    return Keccak_HashInitialize(&vexof_instance->keccak_instance, 1088, 512, 0, domain);
+}
+
+/**
+ * Copy on write: take a private copy of the absorbed state that a fork shares with its parent.
+ */
+static void own_state(VeXOF_Instance *vexof_instance)
+{
+    if (vexof_instance->shared)
+        vexof_instance->keccak_instance = vexof_instance->shared->keccak_instance;
+    vexof_instance->shared = NULL;
+}
+
+/**
+ * Absorb bytes with the permutation of the given number of rounds.
+ */
+static int absorb(Keccak_HashInstance *keccak_instance, unsigned int rounds, const uint8_t *data, size_t bytes)
+{
+    if (rounds == 12)
+    {
+        // Both sponge instances are declared with XKCP_DeclareSpongeStructure and share their layout
+        return KeccakWidth1600_12rounds_SpongeAbsorb(
+            (KeccakWidth1600_12rounds_SpongeInstance *)&keccak_instance->sponge, data, bytes);
+    }
+    return Keccak_HashUpdate(keccak_instance, data, 8 * bytes);
+}
+
 /**
  * Add bytes to instance
  */
 int VeXOF_HashUpdate(VeXOF_Instance *vexof_instance, const uint8_t *data, size_t bytes)
 {
-    vexof_instance->squeezing = 0;
-    return Keccak_HashUpdate(&vexof_instance->keccak_instance, data, 8 * bytes);
+    own_state(vexof_instance);
+    start_absorbing(vexof_instance);
+    return absorb(&vexof_instance->keccak_instance, vexof_instance->rounds, data, bytes);
 }
 
 /**
- * Squeeze bytes in parallel.
+ * Little endian encoding of block indices, labels and the exported state, independent of the platform.
  */
-int VeXOF_Squeeze(VeXOF_Instance *vexof_instance, uint64_t *data, size_t num_bytes)
+static void store64(uint8_t *data, uint64_t value)
 {
-    check(num_bytes % 8 == 0);
+    for (unsigned int idx = 0; idx < 8; idx++)
+        data[idx] = (uint8_t)(value >> (8 * idx));
+}
+
+static uint64_t load64(const uint8_t *data)
+{
+    uint64_t value = 0;
+    for (unsigned int idx = 0; idx < 8; idx++)
+        value |= (uint64_t)data[idx] << (8 * idx);
+    return value;
+}
+
+/**
+ * Whether the squeeze kernels can generate the blocks of a state absorbed up to byte_io_index: they add
+ * the block index to a single lane, and need the padding in the same block.
+ */
+static int counter_in_lane(unsigned int byte_io_index, uint32_t bytes_rate)
+{
+    return byte_io_index % 8 == 0 && byte_io_index + 8 < bytes_rate;
+}
+
+/**
+ * Switch from absorbing to squeezing: prepare the template state, padded if the squeeze kernels are used.
+ */
+static int prepare_squeeze(VeXOF_Instance *vexof_instance)
+{
+    own_state(vexof_instance);
 
     KeccakWidth1600_SpongeInstance *sponge = &vexof_instance->keccak_instance.sponge;
     uint32_t bytes_rate = sponge->rate / 8;
 
-    if (!vexof_instance->squeezing)
+    // The backends broadcast the template to all parallel instances
+    memcpy(vexof_instance->prepared_state, sponge->state, 200);
+    if (counter_in_lane(sponge->byteIOIndex, bytes_rate))
     {
-        check(sponge->byteIOIndex % 8 == 0);
-        check(sponge->byteIOIndex < (bytes_rate - 10));
+        // SHAKE padding
+        vexof_instance->prepared_state[sponge->byteIOIndex + 8] ^= vexof_instance->keccak_instance.delimitedSuffix;
+        vexof_instance->prepared_state[bytes_rate - 1] ^= 0x80;
+    }
+
+    vexof_instance->backend = get_backend();
+
+    vexof_instance->buffer_pos = 0;
+    vexof_instance->buffer_len = 0;
+    vexof_instance->block = 0;
+    vexof_instance->index = 0;
+    vexof_instance->squeezing = 1;
+    vexof_instance->interleaved = 0;
 
-        uint64_t *state64 = (uint64_t *)sponge->state;
-        uint64_t *prep64 = (uint64_t *)vexof_instance->prepared_state;
-        for (int idx = 0; idx < PARALLELISM; idx++)
+    return 0;
+}
+
+/**
+ * Fill the first num_lanes instances of states with the blocks of the given indices, from an unpadded state
+ * absorbed up to byte_io_index, for block indices that the squeeze kernels cannot add, and permute them. The
+ * block index is added at any byte position. If it reaches the end of the block, its remaining bytes and the
+ * padding are absorbed in the next block, which takes a second permutation.
+ */
+static void permute_indices(const VeXOF_Backend *backend, const uint8_t *state, unsigned int rounds,
+                            uint32_t bytes_rate, unsigned int byte_io_index, uint8_t domain, const uint64_t indices[],
+                            unsigned int num_lanes, uint8_t *states)
+{
+    void (*permute)(void *) = rounds == 12 ? backend->permute_12rounds : backend->permute_24rounds;
+    unsigned int first_bytes = byte_io_index + 8 <= bytes_rate ? 8 : bytes_rate - byte_io_index;
+    unsigned int padding_offset = byte_io_index + 8 < bytes_rate ? byte_io_index + 8 : 8 - first_bytes;
+    int padding_block = byte_io_index + 8 >= bytes_rate;
+    const uint8_t last = 0x80;
+
+    uint8_t index[8];
+    for (unsigned int lane = 0; lane < num_lanes; lane++)
+    {
+        store64(index, indices[lane]);
+        backend->overwrite_bytes(states, lane, state, 0, 200);
+        backend->add_bytes(states, lane, index, byte_io_index, first_bytes);
+    }
+    if (padding_block)
+    {
+        permute(states);
+        for (unsigned int lane = 0; lane < num_lanes && first_bytes < 8; lane++)
         {
-            for (int idx2 = 0; idx2 < 25; idx2++)
-                prep64[idx + idx2 * PARALLELISM] = state64[idx2];
-            // SHAKE padding. Use the (uint8_t *)prepared_state here
-            vexof_instance->prepared_state[idx * 8 + (sponge->byteIOIndex + 8) * PARALLELISM] ^= vexof_instance->keccak_instance.delimitedSuffix;
-            vexof_instance->prepared_state[idx * 8 + (bytes_rate - 8) * PARALLELISM + 7] ^= 0x80;
+            store64(index, indices[lane]);
+            backend->add_bytes(states, lane, index + first_bytes, 0, 8 - first_bytes);
         }
-
-        vexof_instance->block = 0;
-        vexof_instance->index = 0;
-        vexof_instance->squeezing = 1;
     }
+    for (unsigned int lane = 0; lane < num_lanes; lane++)
+    {
+        backend->add_bytes(states, lane, &domain, padding_offset, 1);
+        backend->add_bytes(states, lane, &last, bytes_rate - 1, 1);
+    }
+    permute(states);
+}
+
+/**
+ * permute_indices for the blocks from block on.
+ */
+static void permute_any_position(const VeXOF_Backend *backend, const uint8_t *state, unsigned int rounds,
+                                 uint32_t bytes_rate, unsigned int byte_io_index, uint8_t domain, uint64_t block,
+                                 unsigned int num_lanes, uint8_t *states)
+{
+    uint64_t indices[VEXOF_MAX_PARALLELISM];
+    for (unsigned int lane = 0; lane < num_lanes; lane++)
+        indices[lane] = block + lane;
+    permute_indices(backend, state, rounds, bytes_rate, byte_io_index, domain, indices, num_lanes, states);
+}
 
-    uint8_t *states = &vexof_instance->states_data[0];
-    size_t last_idx = vexof_instance->index + num_bytes;
-    uint64_t *states64 = (uint64_t *)states;
-    uint64_t *data64 = data;
+/**
+ * Generate num_bytes of output from block on, from an unpadded state absorbed up to byte_io_index, for
+ * block indices that the squeeze kernels cannot add.
+ */
+static void squeeze_any_position(const VeXOF_Backend *backend, const uint8_t *state, unsigned int rounds,
+                                 uint32_t bytes_rate, unsigned int byte_io_index, uint8_t domain, uint64_t block,
+                                 uint8_t *data, size_t num_bytes)
+{
+    ALIGN(64)
+    uint8_t states[200 * VEXOF_MAX_PARALLELISM];
 
-    // Squeeze bytes already created in a preceding invocation
-    uint32_t mod_index = vexof_instance->index % (PARALLELISM * bytes_rate);
-    if (mod_index)
+    while (num_bytes)
     {
-        size_t remaining = PARALLELISM * bytes_rate - mod_index;
-        if (remaining > num_bytes)
-            remaining = num_bytes;
+        unsigned int num_lanes = 0;
+        while (num_lanes < backend->parallelism && num_lanes * bytes_rate < num_bytes)
+            num_lanes++;
+        permute_any_position(backend, state, rounds, bytes_rate, byte_io_index, domain, block, num_lanes, states);
 
-        for (size_t idx = 0; idx < remaining / 8; idx++)
+        for (unsigned int lane = 0; lane < num_lanes; lane++)
         {
-            uint32_t idx1 = mod_index + 8 * idx;
-            uint32_t idx2 = (idx1 % bytes_rate) / 8 * PARALLELISM + (idx1 / bytes_rate);
-            data64[idx] = states64[idx2];
+            size_t bytes = num_bytes < bytes_rate ? num_bytes : bytes_rate;
+            backend->extract_bytes(states, lane, data, 0, bytes);
+            data += bytes;
+            num_bytes -= bytes;
         }
+        block += num_lanes;
+    }
+}
+
+/**
+ * Fill the instances of states with the consecutive blocks of a batch from block on and permute them, for
+ * output that is extracted from the states directly.
+ */
+static void permute_batch(const VeXOF_Instance *vexof_instance, uint64_t block, uint8_t *states)
+{
+    const KeccakWidth1600_SpongeInstance *sponge = &vexof_instance->keccak_instance.sponge;
+    const VeXOF_Backend *backend = vexof_instance->backend;
+    const uint8_t *prepared_state =
+        vexof_instance->shared ? vexof_instance->shared->prepared_state : vexof_instance->prepared_state;
+    uint32_t bytes_rate = sponge->rate / 8;
 
-        data64 += remaining / 8;
-        vexof_instance->index += remaining;
+    if (!counter_in_lane(sponge->byteIOIndex, bytes_rate))
+    {
+        permute_any_position(backend, prepared_state, vexof_instance->rounds, bytes_rate, sponge->byteIOIndex,
+                             vexof_instance->keccak_instance.delimitedSuffix, block, backend->parallelism, states);
+        return;
     }
 
-    while (vexof_instance->index < last_idx)
+    uint8_t index[8];
+    for (unsigned int lane = 0; lane < backend->parallelism; lane++)
     {
-        uint32_t byteIOIndex = sponge->byteIOIndex;
-        memcpy(states, vexof_instance->prepared_state, PARALLELISM * 200);
-        for (int idx = 0; idx < PARALLELISM; idx++)
-        {
-            *((uint64_t *)&states[byteIOIndex * PARALLELISM + 8 * idx]) ^= vexof_instance->block;
-            vexof_instance->block++;
-        }
+        store64(index, block + lane);
+        backend->overwrite_bytes(states, lane, prepared_state, 0, 200);
+        backend->add_bytes(states, lane, index, sponge->byteIOIndex, 8);
+    }
+    if (vexof_instance->rounds == 12)
+        backend->permute_12rounds(states);
+    else
+        backend->permute_24rounds(states);
+}
 
-#if PARALLELISM == 1
-        KeccakP1600_Permute_24rounds(states);
-#elif PARALLELISM == 4
-        KeccakP1600times4_PermuteAll_24rounds(states);
-#elif PARALLELISM == 8
-        KeccakP1600times8_PermuteAll_24rounds(states);
-#else
-#error "PARALLELISM must be 1, 4 or 8"
+/**
+ * Generate num_batches batches of consecutive blocks, as many per batch as the parallelism of backend,
+ * starting at block, and store them de-interleaved in data.
+ */
+static void squeeze_batches(const VeXOF_Instance *vexof_instance, const VeXOF_Backend *backend, uint64_t block,
+                            uint8_t *data, size_t num_batches)
+{
+    const KeccakWidth1600_SpongeInstance *sponge = &vexof_instance->keccak_instance.sponge;
+    const uint8_t *prepared_state =
+        vexof_instance->shared ? vexof_instance->shared->prepared_state : vexof_instance->prepared_state;
+    uint32_t bytes_rate = sponge->rate / 8;
+
+    if (!counter_in_lane(sponge->byteIOIndex, bytes_rate))
+        squeeze_any_position(backend, prepared_state, vexof_instance->rounds, bytes_rate, sponge->byteIOIndex,
+                             vexof_instance->keccak_instance.delimitedSuffix, block, data,
+                             num_batches * backend->parallelism * bytes_rate);
+    else if (vexof_instance->rounds == 12)
+        backend->squeeze_blocks_12rounds(prepared_state, bytes_rate / 8, sponge->byteIOIndex / 8, block, data,
+                                         num_batches);
+    else
+        backend->squeeze_blocks(prepared_state, bytes_rate / 8, sponge->byteIOIndex / 8, block, data, num_batches);
+}
+
+// Batches generated at once for non-temporal stores, few enough to stay in the L1 cache
+#define STREAMING_BATCHES 8
+
+static size_t streaming_min_bytes;
+static size_t streaming_default;
+static pthread_once_t streaming_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Stream output that does not fit in the last level cache, if its size is known.
+ */
+static void select_streaming(void)
+{
+    streaming_default = VEXOF_STREAMING_MIN_BYTES;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    long cache_bytes = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (cache_bytes > 0)
+        streaming_default = cache_bytes;
 #endif
+}
 
-        for (int idx = 0; idx < PARALLELISM; idx++)
-        {
-            size_t bytes = last_idx - vexof_instance->index;
-            if (bytes > bytes_rate)
-                bytes = bytes_rate;
+static size_t get_streaming_min_bytes(void)
+{
+    if (streaming_min_bytes)
+        return streaming_min_bytes;
+    pthread_once(&streaming_once, select_streaming);
+    return streaming_default;
+}
 
-            uint64_t *source64 = states64 + idx;
-            for (size_t idx2 = 0; idx2 < bytes / 8; idx2++)
-            {
-                *data64 = *source64;
-                source64 += PARALLELISM;
-                data64++;
-            }
-            vexof_instance->index += bytes;
+/**
+ * Configure non-temporal stores.
+ */
+int VeXOF_SetStreaming(size_t min_bytes)
+{
+    streaming_min_bytes = min_bytes;
+    return 0;
+}
 
-            if (vexof_instance->index >= last_idx)
-                break;
-        }
+/**
+ * Copy bytes, with non-temporal stores for the cache lines of data that are written completely.
+ */
+static void stream_bytes(uint8_t *data, const uint8_t *source, size_t num_bytes)
+{
+    size_t head = (64 - (uintptr_t)data % 64) % 64;
+    if (head > num_bytes)
+        head = num_bytes;
+    memcpy(data, source, head);
+    data += head;
+    source += head;
+    num_bytes -= head;
+
+#if defined(__x86_64__)
+    for (; num_bytes >= 64; num_bytes -= 64, data += 64, source += 64)
+        for (unsigned int idx = 0; idx < 64; idx += 16)
+            _mm_stream_si128((__m128i *)(data + idx), _mm_loadu_si128((const __m128i *)(source + idx)));
+#endif
+    memcpy(data, source, num_bytes);
+}
+
+/**
+ * Generate batches as squeeze_batches, a few at a time in a buffer in the L1 cache, from which they are
+ * streamed to data. Streamed output bypasses the caches and is not read before it is written.
+ */
+static void stream_batches(const VeXOF_Instance *vexof_instance, const VeXOF_Backend *backend, uint64_t block,
+                           uint8_t *data, size_t num_batches)
+{
+    size_t batch_bytes = backend->parallelism * (vexof_instance->keccak_instance.sponge.rate / 8);
+    ALIGN(64)
+    uint8_t batches[STREAMING_BATCHES * 168 * VEXOF_MAX_PARALLELISM];
+
+    while (num_batches)
+    {
+        size_t count = num_batches < STREAMING_BATCHES ? num_batches : STREAMING_BATCHES;
+        squeeze_batches(vexof_instance, backend, block, batches, count);
+        stream_bytes(data, batches, count * batch_bytes);
+        block += count * backend->parallelism;
+        data += count * batch_bytes;
+        num_batches -= count;
     }
+#if defined(__x86_64__)
+    _mm_sfence();
+#endif
+}
 
-    return 0;
+/**
+ * Generate at least num_blocks blocks, starting at block, in a single batch of the narrowest backend
+ * that covers them. Returns the number of blocks stored in data.
+ */
+static unsigned int squeeze_partial_batch(const VeXOF_Instance *vexof_instance, uint64_t block, uint8_t *data,
+                                          size_t num_blocks)
+{
+    const VeXOF_Backend *backend = narrow_backend(vexof_instance->backend, num_blocks);
+    squeeze_batches(vexof_instance, backend, block, data, 1);
+    return backend->parallelism;
 }
 
 /**
- * Generate XOF data from a seed.
+ * Keep the blocks of a batch, generated from vexof_instance->block on, of which bytes_read have been read.
+ * Compact instances only keep the block at the new position. Otherwise batch is the buffer itself.
  */
-void vexof(const uint8_t *seed, size_t input_bytes, uint64_t *output, size_t output_bytes)
+static void keep_batch(VeXOF_Instance *vexof_instance, const uint8_t *batch, unsigned int num_blocks,
+                       uint32_t bytes_read)
 {
-    assert(input_bytes <= 152);
+    uint32_t bytes_rate = vexof_instance->keccak_instance.sponge.rate / 8;
 
-    if (output_bytes > 168)
+#ifdef VEXOF_COMPACT
+    unsigned int num_read = bytes_read / bytes_rate;
+    if (num_read < num_blocks)
     {
-        VeXOF_Instance vexofInstance;
-        VeXOF_HashInitialize(&vexofInstance);
-        VeXOF_HashUpdate(&vexofInstance, seed, input_bytes);
-        VeXOF_Squeeze(&vexofInstance, output, output_bytes);
+        memcpy(vexof_instance->buffer, batch + num_read * bytes_rate, bytes_rate);
+        vexof_instance->block += num_read + 1;
+        vexof_instance->buffer_pos = bytes_read - num_read * bytes_rate;
+        vexof_instance->buffer_len = bytes_rate;
+    }
+    else
+    {
+        vexof_instance->block += num_blocks;
+        vexof_instance->buffer_pos = 0;
+        vexof_instance->buffer_len = 0;
+    }
+#else
+    (void)batch;
+    vexof_instance->block += num_blocks;
+    vexof_instance->buffer_pos = bytes_read;
+    vexof_instance->buffer_len = num_blocks * bytes_rate;
+#endif
+    vexof_instance->index += bytes_read;
+}
+
+/**
+ * Move a squeezing instance to byte index of the output stream, regenerating the block that is read there.
+ */
+static void seek(VeXOF_Instance *vexof_instance, uint64_t index)
+{
+    uint32_t bytes_rate = vexof_instance->keccak_instance.sponge.rate / 8;
+    uint32_t skip = index % bytes_rate;
+
+    vexof_instance->block = index / bytes_rate;
+    vexof_instance->index = index - skip;
+    vexof_instance->buffer_pos = 0;
+    vexof_instance->buffer_len = 0;
+    if (skip)
+    {
+#ifdef VEXOF_COMPACT
+        ALIGN(64)
+        uint8_t batch[168 * VEXOF_MAX_PARALLELISM];
+#else
+        uint8_t *batch = vexof_instance->buffer;
+#endif
+        unsigned int num_blocks = squeeze_partial_batch(vexof_instance, vexof_instance->block, batch, 1);
+        keep_batch(vexof_instance, batch, num_blocks, skip);
+    }
+}
+
+/**
+ * Squeeze bytes in parallel.
+ */
+int VeXOF_Squeeze(VeXOF_Instance *vexof_instance, uint64_t *data, size_t num_bytes)
+{
+    check(num_bytes % 8 == 0);
+    return VeXOF_SqueezeBytes(vexof_instance, (uint8_t *)data, num_bytes);
+}
+
+/**
+ * Squeeze any number of bytes in parallel. The position in the output stream is kept per byte.
+ */
+int VeXOF_SqueezeBytes(VeXOF_Instance *vexof_instance, uint8_t *data, size_t num_bytes)
+{
+    KeccakWidth1600_SpongeInstance *sponge = &vexof_instance->keccak_instance.sponge;
+    uint32_t bytes_rate = sponge->rate / 8;
+
+    if (!vexof_instance->squeezing)
+        check(prepare_squeeze(vexof_instance) == 0);
+    check(!vexof_instance->interleaved);
+
+    unsigned int parallelism = vexof_instance->backend->parallelism;
+    uint32_t batch_bytes = parallelism * bytes_rate;
+    uint8_t *data8 = data;
+#ifdef VEXOF_COMPACT
+    ALIGN(64)
+    uint8_t batch[168 * VEXOF_MAX_PARALLELISM];
+#else
+    uint8_t *batch = vexof_instance->buffer;
+#endif
+
+    // Squeeze bytes already created in a preceding invocation
+    if (vexof_instance->buffer_pos < vexof_instance->buffer_len)
+    {
+        size_t bytes = vexof_instance->buffer_len - vexof_instance->buffer_pos;
+        if (bytes > num_bytes)
+            bytes = num_bytes;
+
+        memcpy(data8, &vexof_instance->buffer[vexof_instance->buffer_pos], bytes);
+        vexof_instance->buffer_pos += bytes;
+        vexof_instance->index += bytes;
+        data8 += bytes;
+        num_bytes -= bytes;
+    }
+
+    // Full batches are stored directly in the output
+    if (num_bytes >= batch_bytes)
+    {
+        size_t num_batches = num_bytes / batch_bytes;
+        if (num_bytes >= get_streaming_min_bytes())
+            stream_batches(vexof_instance, vexof_instance->backend, vexof_instance->block, data8, num_batches);
+        else
+            squeeze_batches(vexof_instance, vexof_instance->backend, vexof_instance->block, data8, num_batches);
+        vexof_instance->block += num_batches * parallelism;
+        vexof_instance->index += num_batches * batch_bytes;
+        data8 += num_batches * batch_bytes;
+        num_bytes -= num_batches * batch_bytes;
+    }
+
+    // Keep the remainder of the last batch for a next invocation
+    if (num_bytes)
+    {
+        unsigned int num_blocks = squeeze_partial_batch(vexof_instance, vexof_instance->block, batch,
+                                                        (num_bytes + bytes_rate - 1) / bytes_rate);
+        memcpy(data8, batch, num_bytes);
+        keep_batch(vexof_instance, batch, num_blocks, num_bytes);
+    }
+
+    return 0;
+}
+
+/**
+ * Squeeze bytes through the buffer, which is refilled with as many blocks as it holds when empty.
+ */
+int VeXOF_SqueezeBuffered(VeXOF_Instance *vexof_instance, uint8_t *data, size_t num_bytes)
+{
+    uint32_t bytes_rate = vexof_instance->keccak_instance.sponge.rate / 8;
+
+    if (!vexof_instance->squeezing)
+        check(prepare_squeeze(vexof_instance) == 0);
+    check(!vexof_instance->interleaved);
+
+    uint32_t batch_bytes = vexof_instance->backend->parallelism * bytes_rate;
+#ifdef VEXOF_COMPACT
+    ALIGN(64)
+    uint8_t batch[168 * VEXOF_MAX_PARALLELISM];
+#else
+    uint8_t *batch = vexof_instance->buffer;
+#endif
+
+    while (num_bytes)
+    {
+        if (vexof_instance->buffer_pos == vexof_instance->buffer_len)
+        {
+            // Full batches are stored directly in the output
+            if (num_bytes >= batch_bytes)
+            {
+                size_t bytes = num_bytes - num_bytes % batch_bytes;
+                check(VeXOF_SqueezeBytes(vexof_instance, data, bytes) == 0);
+                data += bytes;
+                num_bytes -= bytes;
+                continue;
+            }
+
+            unsigned int num_blocks = squeeze_partial_batch(vexof_instance, vexof_instance->block, batch,
+                                                            sizeof(vexof_instance->buffer) / bytes_rate);
+            keep_batch(vexof_instance, batch, num_blocks, 0);
+        }
+
+        size_t bytes = vexof_instance->buffer_len - vexof_instance->buffer_pos;
+        if (bytes > num_bytes)
+            bytes = num_bytes;
+
+        memcpy(data, &vexof_instance->buffer[vexof_instance->buffer_pos], bytes);
+        vexof_instance->buffer_pos += bytes;
+        vexof_instance->index += bytes;
+        data += bytes;
+        num_bytes -= bytes;
+    }
+
+    return 0;
+}
+
+/**
+ * Squeeze bytes in chunks that are passed to a consumer while they are in the cache.
+ */
+int VeXOF_SqueezeStream(VeXOF_Instance *vexof_instance, size_t num_bytes, size_t chunk_bytes,
+                        VeXOF_Consumer consumer, void *context)
+{
+    ALIGN(64)
+    uint8_t chunk[VEXOF_STREAM_CHUNK_BYTES];
+
+    if (!chunk_bytes)
+        chunk_bytes = VEXOF_STREAM_CHUNK_BYTES;
+    check(chunk_bytes <= VEXOF_STREAM_CHUNK_BYTES);
+
+    while (num_bytes)
+    {
+        size_t bytes = num_bytes < chunk_bytes ? num_bytes : chunk_bytes;
+        check(VeXOF_SqueezeBytes(vexof_instance, chunk, bytes) == 0);
+        int ret = consumer(context, chunk, bytes);
+        if (ret)
+            return ret;
+        num_bytes -= bytes;
+    }
+
+    return 0;
+}
+
+/**
+ * Generate num_groups groups of VEXOF_INTERLEAVED_BLOCKS consecutive blocks, from group on, and store them
+ * in interleaved order in data.
+ */
+static void squeeze_interleaved_groups(const VeXOF_Instance *vexof_instance, uint64_t group, uint8_t *data,
+                                       size_t num_groups)
+{
+    const KeccakWidth1600_SpongeInstance *sponge = &vexof_instance->keccak_instance.sponge;
+    const VeXOF_Backend *backend = vexof_instance->backend;
+    const uint8_t *prepared_state =
+        vexof_instance->shared ? vexof_instance->shared->prepared_state : vexof_instance->prepared_state;
+    uint32_t bytes_rate = sponge->rate / 8;
+    uint64_t block = group * VEXOF_INTERLEAVED_BLOCKS;
+
+    if (counter_in_lane(sponge->byteIOIndex, bytes_rate))
+    {
+        size_t num_batches = num_groups * VEXOF_INTERLEAVED_BLOCKS / backend->parallelism;
+        if (vexof_instance->rounds == 12)
+            backend->squeeze_interleaved_12rounds(prepared_state, bytes_rate / 8, sponge->byteIOIndex / 8, block,
+                                                  data, num_batches);
+        else
+            backend->squeeze_interleaved(prepared_state, bytes_rate / 8, sponge->byteIOIndex / 8, block, data,
+                                         num_batches);
+        return;
+    }
+
+    // Interleave the blocks of the generic path
+    ALIGN(64)
+    uint8_t blocks[168 * VEXOF_INTERLEAVED_BLOCKS];
+    for (; num_groups; num_groups--, block += VEXOF_INTERLEAVED_BLOCKS)
+    {
+        squeeze_any_position(backend, prepared_state, vexof_instance->rounds, bytes_rate, sponge->byteIOIndex,
+                             vexof_instance->keccak_instance.delimitedSuffix, block, blocks,
+                             VEXOF_INTERLEAVED_BLOCKS * bytes_rate);
+        for (uint32_t lane = 0; lane < bytes_rate / 8; lane++)
+            for (unsigned int idx = 0; idx < VEXOF_INTERLEAVED_BLOCKS; idx++)
+                memcpy(data + (lane * VEXOF_INTERLEAVED_BLOCKS + idx) * 8, blocks + idx * bytes_rate + lane * 8, 8);
+        data += VEXOF_INTERLEAVED_BLOCKS * bytes_rate;
+    }
+}
+
+/**
+ * Squeeze bytes in interleaved order. Partial groups at either end are generated in full.
+ */
+int VeXOF_SqueezeInterleaved(VeXOF_Instance *vexof_instance, unsigned int version, uint8_t *data, size_t num_bytes)
+{
+    check(version == VEXOF_INTERLEAVED_VERSION);
+
+    if (!vexof_instance->squeezing)
+        check(prepare_squeeze(vexof_instance) == 0);
+    if (!vexof_instance->interleaved)
+    {
+        // The position of the other squeeze functions has no meaning in the interleaved order
+        check(vexof_instance->index == 0 && vexof_instance->buffer_pos == vexof_instance->buffer_len);
+        vexof_instance->interleaved = 1;
+    }
+
+    uint32_t group_bytes = VEXOF_INTERLEAVED_BLOCKS * (vexof_instance->keccak_instance.sponge.rate / 8);
+    uint64_t group = vexof_instance->index / group_bytes;
+    uint32_t skip = vexof_instance->index % group_bytes;
+    ALIGN(64)
+    uint8_t group_data[168 * VEXOF_INTERLEAVED_BLOCKS];
+
+    vexof_instance->index += num_bytes;
+
+    if (skip && num_bytes)
+    {
+        size_t bytes = group_bytes - skip;
+        if (bytes > num_bytes)
+            bytes = num_bytes;
+
+        squeeze_interleaved_groups(vexof_instance, group++, group_data, 1);
+        memcpy(data, group_data + skip, bytes);
+        data += bytes;
+        num_bytes -= bytes;
+    }
+
+    // Full groups are stored directly in the output
+    if (num_bytes >= group_bytes)
+    {
+        size_t num_groups = num_bytes / group_bytes;
+        squeeze_interleaved_groups(vexof_instance, group, data, num_groups);
+        group += num_groups;
+        data += num_groups * group_bytes;
+        num_bytes -= num_groups * group_bytes;
+    }
+
+    if (num_bytes)
+    {
+        squeeze_interleaved_groups(vexof_instance, group, group_data, 1);
+        memcpy(data, group_data, num_bytes);
+    }
+
+    return 0;
+}
+
+/**
+ * A batch of which the blocks are being extracted into buffers, kept across the chunks of buffers of
+ * one layout so that the bytes at the end of a chunk do not go through the instance buffer.
+ */
+typedef struct
+{
+    ALIGN(64)
+    uint8_t states[200 * VEXOF_MAX_PARALLELISM];
+    uint32_t batch_pos;
+    int live;
+} Scatter_Batch;
+
+/**
+ * Keep the blocks of the pending batch that were not read completely for a next invocation.
+ */
+static void finish_scatter(VeXOF_Instance *vexof_instance, Scatter_Batch *pending)
+{
+    const VeXOF_Backend *backend = vexof_instance->backend;
+    uint32_t bytes_rate = vexof_instance->keccak_instance.sponge.rate / 8;
+#ifdef VEXOF_COMPACT
+    ALIGN(64)
+    uint8_t batch[168 * VEXOF_MAX_PARALLELISM];
+#else
+    uint8_t *batch = vexof_instance->buffer;
+#endif
+
+    for (unsigned int lane = pending->batch_pos / bytes_rate; lane < backend->parallelism; lane++)
+        backend->extract_bytes(pending->states, lane, batch + lane * bytes_rate, 0, bytes_rate);
+    keep_batch(vexof_instance, batch, backend->parallelism, pending->batch_pos);
+    pending->live = 0;
+}
+
+/**
+ * Fill the buffers, continuing the pending batch. Unless last is set, a batch that is not read completely
+ * stays pending for the next chunk of buffers.
+ */
+static int scatter(VeXOF_Instance *vexof_instance, const struct iovec *iov, size_t iov_count, Scatter_Batch *pending,
+                   int last)
+{
+    uint32_t bytes_rate = vexof_instance->keccak_instance.sponge.rate / 8;
+
+    if (!vexof_instance->squeezing)
+        check(prepare_squeeze(vexof_instance) == 0);
+    check(!vexof_instance->interleaved);
+
+    const VeXOF_Backend *backend = vexof_instance->backend;
+    unsigned int parallelism = backend->parallelism;
+    uint32_t batch_bytes = parallelism * bytes_rate;
+    size_t segment = 0, segment_pos = 0;
+
+    while (segment < iov_count)
+    {
+        uint8_t *data = (uint8_t *)iov[segment].iov_base + segment_pos;
+        size_t num_bytes = iov[segment].iov_len - segment_pos;
+
+        if (!num_bytes)
+        {
+            segment++;
+            segment_pos = 0;
+            continue;
+        }
+
+        // Squeeze bytes already created in a preceding invocation
+        if (vexof_instance->buffer_pos < vexof_instance->buffer_len)
+        {
+            size_t bytes = vexof_instance->buffer_len - vexof_instance->buffer_pos;
+            if (bytes > num_bytes)
+                bytes = num_bytes;
+
+            memcpy(data, &vexof_instance->buffer[vexof_instance->buffer_pos], bytes);
+            vexof_instance->buffer_pos += bytes;
+            vexof_instance->index += bytes;
+            segment_pos += bytes;
+            continue;
+        }
+
+        // Full batches are stored directly in the buffer
+        if (!pending->live && num_bytes >= batch_bytes)
+        {
+            size_t num_batches = num_bytes / batch_bytes;
+            if (num_bytes >= get_streaming_min_bytes())
+                stream_batches(vexof_instance, backend, vexof_instance->block, data, num_batches);
+            else
+                squeeze_batches(vexof_instance, backend, vexof_instance->block, data, num_batches);
+            vexof_instance->block += num_batches * parallelism;
+            vexof_instance->index += num_batches * batch_bytes;
+            segment_pos += num_batches * batch_bytes;
+            continue;
+        }
+
+        // Extract the blocks of a batch into the buffers, as far as they go
+        if (!pending->live)
+        {
+            permute_batch(vexof_instance, vexof_instance->block, pending->states);
+            pending->batch_pos = 0;
+            pending->live = 1;
+        }
+        while (pending->batch_pos < batch_bytes && segment < iov_count)
+        {
+            unsigned int lane = pending->batch_pos / bytes_rate;
+            uint32_t offset = pending->batch_pos % bytes_rate;
+            size_t bytes = iov[segment].iov_len - segment_pos;
+            if (bytes > bytes_rate - offset)
+                bytes = bytes_rate - offset;
+
+            backend->extract_bytes(pending->states, lane, (uint8_t *)iov[segment].iov_base + segment_pos, offset,
+                                   bytes);
+            pending->batch_pos += bytes;
+            segment_pos += bytes;
+            if (segment_pos == iov[segment].iov_len)
+            {
+                segment++;
+                segment_pos = 0;
+            }
+        }
+
+        if (pending->batch_pos < batch_bytes && !last)
+            return 0;
+        finish_scatter(vexof_instance, pending);
+    }
+
+    if (pending->live && last)
+        finish_scatter(vexof_instance, pending);
+
+    return 0;
+}
+
+/**
+ * Squeeze bytes into a list of buffers. Full batches within a buffer are generated by the squeeze kernels,
+ * the blocks of other batches are extracted from the permuted states straight into the buffers they
+ * belong to.
+ */
+int VeXOF_SqueezeScatter(VeXOF_Instance *vexof_instance, const struct iovec *iov, size_t iov_count)
+{
+    Scatter_Batch pending;
+    pending.live = 0;
+    return scatter(vexof_instance, iov, iov_count, &pending, 1);
+}
+
+// Buffers passed to VeXOF_SqueezeScatter at once for layouts
+#define SCATTER_SEGMENTS 64
+
+/**
+ * Squeeze bytes into the tiles of a matrix, tile by tile.
+ */
+int VeXOF_SqueezeTiles(VeXOF_Instance *vexof_instance, uint8_t *data, size_t row_stride, size_t tile_bytes,
+                       size_t tile_rows, size_t tiles_across, size_t tiles_down)
+{
+    struct iovec iov[SCATTER_SEGMENTS];
+    size_t num_segments = 0;
+    Scatter_Batch pending;
+    pending.live = 0;
+
+    check(tiles_across * tile_bytes <= row_stride || tile_rows * tiles_down < 2);
+
+    for (size_t tile_row = 0; tile_row < tiles_down; tile_row++)
+        for (size_t tile = 0; tile < tiles_across; tile++)
+            for (size_t row = 0; row < tile_rows; row++)
+            {
+                iov[num_segments].iov_base = data + (tile_row * tile_rows + row) * row_stride + tile * tile_bytes;
+                iov[num_segments].iov_len = tile_bytes;
+                if (++num_segments == SCATTER_SEGMENTS)
+                {
+                    check(scatter(vexof_instance, iov, num_segments, &pending, 0) == 0);
+                    num_segments = 0;
+                }
+            }
+
+    return scatter(vexof_instance, iov, num_segments, &pending, 1);
+}
+
+/**
+ * Squeeze bytes into rows at a fixed distance from each other: a single tile.
+ */
+int VeXOF_SqueezeRows(VeXOF_Instance *vexof_instance, uint8_t *data, size_t row_bytes, size_t row_stride,
+                      size_t num_rows)
+{
+    return VeXOF_SqueezeTiles(vexof_instance, data, row_stride, row_bytes, num_rows, 1, 1);
+}
+
+/**
+ * XOR output bytes into data, a chunk in the L1 cache at a time.
+ */
+int VeXOF_SqueezeXor(VeXOF_Instance *vexof_instance, const uint8_t *input, uint8_t *output, size_t num_bytes)
+{
+    ALIGN(64)
+    uint8_t chunk[STREAMING_BATCHES * 168 * VEXOF_MAX_PARALLELISM];
+
+    // Output words would overwrite input words that are still to be read
+    uintptr_t input_address = (uintptr_t)input, output_address = (uintptr_t)output;
+    check(input_address == output_address || input_address + num_bytes <= output_address ||
+          output_address + num_bytes <= input_address);
+
+    while (num_bytes)
+    {
+        size_t bytes = num_bytes < sizeof(chunk) ? num_bytes : sizeof(chunk);
+        check(VeXOF_SqueezeBytes(vexof_instance, chunk, bytes) == 0);
+
+        // Each word of input is loaded before the word of output is stored, so they can be the same
+        size_t idx = 0;
+#if defined(__x86_64__)
+        for (; idx + 16 <= bytes; idx += 16)
+            _mm_storeu_si128((__m128i *)(output + idx),
+                             _mm_xor_si128(_mm_loadu_si128((const __m128i *)(input + idx)),
+                                           _mm_load_si128((const __m128i *)(chunk + idx))));
+#endif
+        for (; idx < bytes; idx++)
+            output[idx] = input[idx] ^ chunk[idx];
+
+        input += bytes;
+        output += bytes;
+        num_bytes -= bytes;
+    }
+
+    return 0;
+}
+
+/**
+ * Export the absorbed state and the position in the output stream.
+ */
+int VeXOF_Export(const VeXOF_Instance *vexof_instance, uint8_t data[VEXOF_EXPORT_BYTES])
+{
+    const KeccakWidth1600_SpongeInstance *sponge = &vexof_instance->keccak_instance.sponge;
+    const VeXOF_Instance *owner = vexof_instance->shared ? vexof_instance->shared : vexof_instance;
+    const uint64_t *lanes = (const uint64_t *)owner->keccak_instance.sponge.state;
+
+    // The exported position is one in the output stream of VeXOF_Squeeze
+    check(!vexof_instance->interleaved);
+
+    memset(data, 0, VEXOF_EXPORT_BYTES);
+    memcpy(data, "VXOF", 4);
+    data[4] = VEXOF_EXPORT_VERSION;
+    data[5] = (uint8_t)vexof_instance->rounds;
+    data[6] = (uint8_t)(sponge->rate / 8);
+    data[7] = vexof_instance->keccak_instance.delimitedSuffix;
+    data[8] = (uint8_t)sponge->byteIOIndex;
+    data[9] = vexof_instance->squeezing ? 1 : 0;
+    store64(data + 16, vexof_instance->squeezing ? vexof_instance->index : 0);
+    for (unsigned int idx = 0; idx < 25; idx++)
+        store64(data + 24 + 8 * idx, lanes[idx]);
+
+    return 0;
+}
+
+/**
+ * Restore an instance exported by VeXOF_Export.
+ */
+int VeXOF_Import(VeXOF_Instance *vexof_instance, const uint8_t data[VEXOF_EXPORT_BYTES])
+{
+    unsigned int rounds = data[5];
+    uint32_t bytes_rate = data[6];
+    uint8_t domain = data[7];
+    unsigned int byte_io_index = data[8];
+
+    if (memcmp(data, "VXOF", 4) || data[4] != VEXOF_EXPORT_VERSION)
+        return 1;
+    if ((rounds != 12 && rounds != 24) || (bytes_rate != 168 && bytes_rate != 136))
+        return 1;
+    if (domain < 0x01 || domain > 0x7F || byte_io_index >= bytes_rate || data[9] > 1)
+        return 1;
+    // Reserved, so that later versions of the format are not taken for this one
+    for (unsigned int idx = 10; idx < 16; idx++)
+        if (data[idx])
+            return 1;
+
+    if (Keccak_HashInitialize(&vexof_instance->keccak_instance, 8 * bytes_rate, 1600 - 8 * bytes_rate, 0, domain))
+        return 1;
+    start_absorbing(vexof_instance);
+    vexof_instance->rounds = rounds;
+
+    KeccakWidth1600_SpongeInstance *sponge = &vexof_instance->keccak_instance.sponge;
+    uint64_t *lanes = (uint64_t *)sponge->state;
+    for (unsigned int idx = 0; idx < 25; idx++)
+        lanes[idx] = load64(data + 24 + 8 * idx);
+    sponge->byteIOIndex = byte_io_index;
+
+    if (data[9])
+    {
+        if (prepare_squeeze(vexof_instance))
+            return 1;
+        seek(vexof_instance, load64(data + 16));
+    }
+
+    return 0;
+}
+
+/**
+ * Copy the parameters and the position of an instance, but not its absorbed state.
+ */
+static void copy_position(VeXOF_Instance *copy, const VeXOF_Instance *vexof_instance)
+{
+    copy->keccak_instance.sponge.rate = vexof_instance->keccak_instance.sponge.rate;
+    copy->keccak_instance.sponge.byteIOIndex = vexof_instance->keccak_instance.sponge.byteIOIndex;
+    copy->keccak_instance.delimitedSuffix = vexof_instance->keccak_instance.delimitedSuffix;
+    copy->backend = vexof_instance->backend;
+    copy->rounds = vexof_instance->rounds;
+    copy->squeezing = vexof_instance->squeezing;
+    copy->interleaved = vexof_instance->interleaved;
+    copy->buffer_pos = vexof_instance->buffer_pos;
+    copy->buffer_len = vexof_instance->buffer_len;
+    copy->block = vexof_instance->block;
+    copy->index = vexof_instance->index;
+}
+
+/**
+ * Copy an instance. Only the live parts are copied: the absorbed state, the template when squeezing
+ * and the output that has not been read yet.
+ */
+int VeXOF_Clone(VeXOF_Instance *clone, const VeXOF_Instance *vexof_instance)
+{
+    check(clone != vexof_instance);
+
+    copy_position(clone, vexof_instance);
+    clone->shared = vexof_instance->shared;
+    if (!vexof_instance->shared)
+    {
+        clone->keccak_instance = vexof_instance->keccak_instance;
+        if (vexof_instance->squeezing)
+            memcpy(clone->prepared_state, vexof_instance->prepared_state, 200);
+    }
+    memcpy(clone->buffer + vexof_instance->buffer_pos, vexof_instance->buffer + vexof_instance->buffer_pos,
+           vexof_instance->buffer_len - vexof_instance->buffer_pos);
+
+    return 0;
+}
+
+/**
+ * Create an instance that shares the absorbed state and template of parent until it absorbs more.
+ */
+int VeXOF_Fork(VeXOF_Instance *fork, const VeXOF_Instance *parent)
+{
+    check(fork != parent);
+
+    copy_position(fork, parent);
+    fork->shared = parent->shared ? parent->shared : parent;
+    if (parent->squeezing && !parent->interleaved)
+    {
+        // Copy the unread rest of the block that is being read, which costs no permutation. The blocks
+        // after it are generated again when needed instead of copying the buffer.
+        uint32_t bytes_rate = parent->keccak_instance.sponge.rate / 8;
+        uint32_t rest = bytes_rate - parent->index % bytes_rate;
+        uint32_t buffered = parent->buffer_len - parent->buffer_pos;
+        if (rest < bytes_rate && buffered < rest)
+            seek(fork, parent->index);
+        else
+        {
+            if (rest > buffered)
+                rest = buffered;
+            memcpy(fork->buffer + parent->buffer_pos, parent->buffer + parent->buffer_pos, rest);
+            fork->buffer_len = parent->buffer_pos + rest;
+            fork->block = parent->block - (parent->buffer_len - fork->buffer_len) / bytes_rate;
+        }
+    }
+    else
+    {
+        fork->buffer_pos = 0;
+        fork->buffer_len = 0;
+    }
+
+    return 0;
+}
+
+/**
+ * Squeeze bytes at an arbitrary position of the output stream.
+ */
+int VeXOF_SqueezeAt(VeXOF_Instance *vexof_instance, uint64_t offset, uint64_t *data, size_t num_bytes)
+{
+    check(offset % 8 == 0);
+    check(num_bytes % 8 == 0);
+    return VeXOF_SqueezeBytesAt(vexof_instance, offset, (uint8_t *)data, num_bytes);
+}
+
+/**
+ * Squeeze any number of bytes at any byte position of the output stream.
+ */
+int VeXOF_SqueezeBytesAt(VeXOF_Instance *vexof_instance, uint64_t offset, uint8_t *data, size_t num_bytes)
+{
+    if (!vexof_instance->squeezing)
+        check(prepare_squeeze(vexof_instance) == 0);
+
+    uint32_t bytes_rate = vexof_instance->keccak_instance.sponge.rate / 8;
+    unsigned int parallelism = vexof_instance->backend->parallelism;
+    uint32_t batch_bytes = parallelism * bytes_rate;
+    uint64_t block = offset / bytes_rate;
+    uint32_t skip = offset % bytes_rate;
+    uint8_t *data8 = data;
+    ALIGN(64)
+    uint8_t batch[168 * VEXOF_MAX_PARALLELISM];
+
+    // Partial first block
+    if (skip && num_bytes)
+    {
+        unsigned int num_blocks = squeeze_partial_batch(vexof_instance, block, batch,
+                                                        (skip + num_bytes + bytes_rate - 1) / bytes_rate);
+        size_t bytes = num_blocks * bytes_rate - skip;
+        if (bytes > num_bytes)
+            bytes = num_bytes;
+
+        memcpy(data8, batch + skip, bytes);
+        block += num_blocks;
+        data8 += bytes;
+        num_bytes -= bytes;
+    }
+
+    if (num_bytes >= batch_bytes)
+    {
+        size_t num_batches = num_bytes / batch_bytes;
+        squeeze_batches(vexof_instance, vexof_instance->backend, block, data8, num_batches);
+        block += num_batches * parallelism;
+        data8 += num_batches * batch_bytes;
+        num_bytes -= num_batches * batch_bytes;
+    }
+
+    if (num_bytes)
+    {
+        squeeze_partial_batch(vexof_instance, block, batch, (num_bytes + bytes_rate - 1) / bytes_rate);
+        memcpy(data8, batch, num_bytes);
+    }
+
+    return 0;
+}
+
+/**
+ * Worker pool for VeXOF_SqueezeParallel. The calling thread acts as worker 0.
+ */
+static struct
+{
+    pthread_mutex_t lock;
+    pthread_mutex_t mutex;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    pthread_t threads[VEXOF_MAX_THREADS];
+    unsigned int num_threads;
+    unsigned int num_workers;
+    size_t min_bytes;
+    uint64_t generation;
+    uint64_t start_generation;
+    unsigned int pending;
+    int stop;
+    const VeXOF_Instance *vexof_instance;
+    uint64_t block;
+    uint8_t *data;
+    size_t num_batches;
+    int streaming;
+} pool = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .start = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+/**
+ * Squeeze the share of the current job of one worker.
+ */
+static void pool_squeeze(unsigned int worker)
+{
+    unsigned int parallelism = pool.vexof_instance->backend->parallelism;
+    uint32_t batch_bytes = parallelism * pool.vexof_instance->keccak_instance.sponge.rate / 8;
+    size_t first = pool.num_batches * worker / pool.num_threads;
+    size_t last = pool.num_batches * (worker + 1) / pool.num_threads;
+
+    if (pool.streaming)
+        stream_batches(pool.vexof_instance, pool.vexof_instance->backend, pool.block + first * parallelism,
+                       pool.data + first * batch_bytes, last - first);
+    else
+        squeeze_batches(pool.vexof_instance, pool.vexof_instance->backend, pool.block + first * parallelism,
+                        pool.data + first * batch_bytes, last - first);
+}
+
+static void *pool_worker(void *arg)
+{
+    unsigned int worker = (unsigned int)(uintptr_t)arg;
+
+    pthread_mutex_lock(&pool.mutex);
+    uint64_t generation = pool.start_generation;
+    for (;;)
+    {
+        while (pool.generation == generation && !pool.stop)
+            pthread_cond_wait(&pool.start, &pool.mutex);
+        if (pool.stop)
+            break;
+        generation = pool.generation;
+        pthread_mutex_unlock(&pool.mutex);
+
+        pool_squeeze(worker);
+
+        pthread_mutex_lock(&pool.mutex);
+        if (--pool.pending == 0)
+            pthread_cond_signal(&pool.done);
+    }
+    pthread_mutex_unlock(&pool.mutex);
+
+    return NULL;
+}
+
+/**
+ * The number of threads of the pool for a requested number.
+ */
+static unsigned int pool_size(unsigned int num_threads)
+{
+    if (num_threads > VEXOF_MAX_THREADS)
+        return VEXOF_MAX_THREADS;
+    return num_threads < 1 ? 1 : num_threads;
+}
+
+/**
+ * Join the worker threads, leaving the calling thread only. Must be called with pool.lock held.
+ */
+static void pool_stop(void)
+{
+    if (pool.num_workers)
+    {
+        pthread_mutex_lock(&pool.mutex);
+        pool.stop = 1;
+        pthread_cond_broadcast(&pool.start);
+        pthread_mutex_unlock(&pool.mutex);
+        for (unsigned int idx = 0; idx < pool.num_workers; idx++)
+            pthread_join(pool.threads[idx], NULL);
+        pool.num_workers = 0;
+        pool.stop = 0;
+    }
+    pool.num_threads = 1;
+}
+
+/**
+ * (Re)start the worker threads, num_threads as returned by pool_size. If a thread cannot be created,
+ * the pool falls back to the calling thread only. Must be called with pool.lock held.
+ */
+static int pool_start(unsigned int num_threads)
+{
+    pool_stop();
+
+    pool.start_generation = pool.generation;
+    for (unsigned int idx = 1; idx < num_threads; idx++)
+    {
+        if (pthread_create(&pool.threads[pool.num_workers], NULL, pool_worker, (void *)(uintptr_t)idx))
+        {
+            pool_stop();
+            return 1;
+        }
+        pool.num_workers++;
+        pool.num_threads++;
+    }
+
+    return 0;
+}
+
+/**
+ * Configure the worker threads.
+ */
+int VeXOF_SetThreads(unsigned int num_threads, size_t min_bytes)
+{
+    pthread_mutex_lock(&pool.lock);
+    int ret = 0;
+    num_threads = pool_size(num_threads);
+    if (num_threads != pool.num_threads)
+        ret = pool_start(num_threads);
+    pool.min_bytes = min_bytes;
+    pthread_mutex_unlock(&pool.lock);
+
+    return ret;
+}
+
+/**
+ * Squeeze bytes using multiple threads.
+ */
+int VeXOF_SqueezeParallel(VeXOF_Instance *vexof_instance, uint64_t *data, size_t num_bytes)
+{
+    check(num_bytes % 8 == 0);
+
+    if (!vexof_instance->squeezing)
+        check(prepare_squeeze(vexof_instance) == 0);
+    check(!vexof_instance->interleaved);
+
+    pthread_mutex_lock(&pool.lock);
+    if (!pool.num_threads)
+    {
+        // Without worker threads this squeeze, and the following ones, run on the calling thread
+        long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        (void)pool_start(pool_size(num_cpus > 0 ? (unsigned int)num_cpus : 1));
+        pool.min_bytes = VEXOF_THREADS_MIN_BYTES;
+    }
+
+    if (pool.num_threads < 2 || num_bytes < pool.min_bytes)
+    {
+        pthread_mutex_unlock(&pool.lock);
+        return VeXOF_Squeeze(vexof_instance, data, num_bytes);
+    }
+
+    unsigned int parallelism = vexof_instance->backend->parallelism;
+    uint32_t batch_bytes = parallelism * vexof_instance->keccak_instance.sponge.rate / 8;
+    uint8_t *data8 = (uint8_t *)data;
+
+    // Squeeze bytes already created in a preceding invocation
+    size_t bytes = vexof_instance->buffer_len - vexof_instance->buffer_pos;
+    if (bytes > num_bytes)
+        bytes = num_bytes;
+    VeXOF_SqueezeBytes(vexof_instance, data8, bytes);
+    data8 += bytes;
+    num_bytes -= bytes;
+
+    // Divide the full batches over the workers
+    size_t num_batches = num_bytes / batch_bytes;
+    if (num_batches)
+    {
+        pthread_mutex_lock(&pool.mutex);
+        pool.vexof_instance = vexof_instance;
+        pool.block = vexof_instance->block;
+        pool.data = data8;
+        pool.num_batches = num_batches;
+        pool.streaming = num_bytes >= get_streaming_min_bytes();
+        pool.pending = pool.num_workers;
+        pool.generation++;
+        pthread_cond_broadcast(&pool.start);
+        pthread_mutex_unlock(&pool.mutex);
+
+        pool_squeeze(0);
+
+        pthread_mutex_lock(&pool.mutex);
+        while (pool.pending)
+            pthread_cond_wait(&pool.done, &pool.mutex);
+        pthread_mutex_unlock(&pool.mutex);
+
+        vexof_instance->block += num_batches * parallelism;
+        vexof_instance->index += num_batches * batch_bytes;
+        data8 += num_batches * batch_bytes;
+        num_bytes -= num_batches * batch_bytes;
+    }
+    pthread_mutex_unlock(&pool.lock);
+
+    return VeXOF_SqueezeBytes(vexof_instance, data8, num_bytes);
+}
+
+/**
+ * Blocks of different streams packed in the instances of the states, permuted together.
+ */
+typedef struct
+{
+    ALIGN(64)
+    uint8_t states[200 * VEXOF_MAX_PARALLELISM];
+    const VeXOF_Backend *backend;
+    void (*permute)(void *states);
+    unsigned int lane;
+    uint8_t *lane_output[VEXOF_MAX_PARALLELISM];
+    uint32_t lane_bytes[VEXOF_MAX_PARALLELISM];
+} Packed_Lanes;
+
+static void start_lanes(Packed_Lanes *lanes, unsigned int rounds)
+{
+    lanes->backend = get_backend();
+    lanes->permute = rounds == 12 ? lanes->backend->permute_12rounds : lanes->backend->permute_24rounds;
+    lanes->lane = 0;
+}
+
+/**
+ * Permute the filled instances and extract their output.
+ */
+static void flush_lanes(Packed_Lanes *lanes)
+{
+    if (!lanes->lane)
+        return;
+    lanes->permute(lanes->states);
+    for (unsigned int idx = 0; idx < lanes->lane; idx++)
+        lanes->backend->extract_bytes(lanes->states, idx, lanes->lane_output[idx], 0, lanes->lane_bytes[idx]);
+    lanes->lane = 0;
+}
+
+/**
+ * Complete the instance at lanes->lane, of which the input has been set, with the destination of its output.
+ */
+static void next_lane(Packed_Lanes *lanes, uint8_t *output, uint32_t bytes)
+{
+    lanes->lane_output[lanes->lane] = output;
+    lanes->lane_bytes[lanes->lane] = bytes;
+    if (++lanes->lane == lanes->backend->parallelism)
+        flush_lanes(lanes);
+}
+
+/**
+ * Squeeze the output of the common input followed by each suffix, packing (suffix, block) pairs in the
+ * instances of the states. Suffixes that leave room for the block index in the block of the common
+ * input are added to its state without a permutation, longer ones are absorbed from a copy of it.
+ */
+static int batch_squeeze(const Keccak_HashInstance *common, unsigned int rounds, const uint8_t *const suffixes[],
+                         const size_t suffix_lens[], uint8_t *const outputs[], const size_t out_lens[],
+                         size_t num_suffixes)
+{
+    uint32_t bytes_rate = common->sponge.rate / 8;
+    Packed_Lanes lanes;
+    Keccak_HashInstance keccak_instance;
+    ALIGN(8)
+    uint8_t prepared_state[200];
+
+    start_lanes(&lanes, rounds);
+    for (size_t suffix = 0; suffix < num_suffixes; suffix++)
+    {
+        unsigned int block_offset;
+
+        // Compared before narrowing, so that suffixes of 2^32 bytes or more are absorbed
+        if (suffix_lens[suffix] + 8 < bytes_rate - common->sponge.byteIOIndex)
+        {
+            block_offset = common->sponge.byteIOIndex + suffix_lens[suffix];
+            memcpy(prepared_state, common->sponge.state, 200);
+            for (size_t idx = 0; idx < suffix_lens[suffix]; idx++)
+                prepared_state[common->sponge.byteIOIndex + idx] ^= suffixes[suffix][idx];
+        }
+        else
+        {
+            keccak_instance = *common;
+            absorb(&keccak_instance, rounds, suffixes[suffix], suffix_lens[suffix]);
+            block_offset = keccak_instance.sponge.byteIOIndex;
+            memcpy(prepared_state, keccak_instance.sponge.state, 200);
+            if (block_offset + 8 >= bytes_rate)
+            {
+                // The padding takes another permutation, which the other instances do not need
+                squeeze_any_position(lanes.backend, prepared_state, rounds, bytes_rate, block_offset,
+                                     common->delimitedSuffix, 0, outputs[suffix], out_lens[suffix]);
+                continue;
+            }
+        }
+
+        // SHAKE padding after the position of the block index
+        prepared_state[block_offset + 8] ^= common->delimitedSuffix;
+        prepared_state[bytes_rate - 1] ^= 0x80;
+
+        uint64_t block = 0;
+        for (size_t index = 0; index < out_lens[suffix]; index += bytes_rate, block++)
+        {
+            size_t bytes = out_lens[suffix] - index;
+            if (bytes > bytes_rate)
+                bytes = bytes_rate;
+
+            uint8_t index_bytes[8];
+            store64(index_bytes, block);
+            lanes.backend->overwrite_bytes(lanes.states, lanes.lane, prepared_state, 0, 200);
+            lanes.backend->add_bytes(lanes.states, lanes.lane, index_bytes, block_offset, 8);
+            next_lane(&lanes, outputs[suffix] + index, bytes);
+        }
+    }
+    flush_lanes(&lanes);
+
+    return 0;
+}
+
+/**
+ * Squeeze the output of many seeds.
+ */
+int VeXOF_BatchSqueeze(const uint8_t *const seeds[], const size_t seed_lens[], uint8_t *const outputs[],
+                       const size_t out_lens[], size_t num_seeds)
+{
+    Keccak_HashInstance keccak_instance;
+    Keccak_HashInitialize_SHAKE128(&keccak_instance);
+    return batch_squeeze(&keccak_instance, 24, seeds, seed_lens, outputs, out_lens, num_seeds);
+}
+
+/**
+ * Squeeze the output of the absorbed input followed by each of the suffixes.
+ */
+int VeXOF_BatchSqueezeSuffixes(const VeXOF_Instance *vexof_instance, const uint8_t *const suffixes[],
+                               const size_t suffix_lens[], uint8_t *const outputs[], const size_t out_lens[],
+                               size_t num_suffixes)
+{
+    const VeXOF_Instance *owner = vexof_instance->shared ? vexof_instance->shared : vexof_instance;
+    return batch_squeeze(&owner->keccak_instance, owner->rounds, suffixes, suffix_lens, outputs, out_lens,
+                         num_suffixes);
+}
+
+/**
+ * Squeeze labelled substreams: full batches of each substream with the squeeze kernels if the block index
+ * is in a lane, the remaining (label, block) pairs packed in the instances of the states with the label and
+ * block index at any byte position. Labels after which the padding does not fit in the block are absorbed
+ * from a copy of the common state.
+ */
+int VeXOF_SqueezeLabels(const VeXOF_Instance *vexof_instance, const uint64_t labels[], uint8_t *const outputs[],
+                        size_t num_bytes, size_t num_labels)
+{
+    const VeXOF_Instance *owner = vexof_instance->shared ? vexof_instance->shared : vexof_instance;
+    const KeccakWidth1600_SpongeInstance *sponge = &owner->keccak_instance.sponge;
+    uint32_t bytes_rate = sponge->rate / 8;
+    unsigned int label_offset = sponge->byteIOIndex;
+    // The label, the block index and the padding in the block of the common input
+    int in_block = label_offset + 16 < bytes_rate;
+    Packed_Lanes lanes;
+    Keccak_HashInstance keccak_instance;
+    ALIGN(64)
+    uint8_t prepared_state[200];
+    ALIGN(64)
+    uint8_t label_state[200];
+
+    memcpy(prepared_state, sponge->state, 200);
+    if (in_block)
+    {
+        prepared_state[label_offset + 16] ^= owner->keccak_instance.delimitedSuffix;
+        prepared_state[bytes_rate - 1] ^= 0x80;
+    }
+
+    start_lanes(&lanes, owner->rounds);
+    const VeXOF_Backend *backend = lanes.backend;
+    unsigned int parallelism = backend->parallelism;
+    void (*squeeze_blocks)(const void *, unsigned int, unsigned int, uint64_t, unsigned char *, size_t) =
+        owner->rounds == 12 ? backend->squeeze_blocks_12rounds : backend->squeeze_blocks;
+    size_t num_batches = counter_in_lane(label_offset + 8, bytes_rate) ? num_bytes / (parallelism * bytes_rate) : 0;
+    size_t batch_bytes = num_batches * parallelism * bytes_rate;
+
+    for (size_t label = 0; label < num_labels; label++)
+    {
+        uint8_t label_bytes[8];
+        store64(label_bytes, labels[label]);
+
+        if (!in_block)
+        {
+            keccak_instance = owner->keccak_instance;
+            absorb(&keccak_instance, owner->rounds, label_bytes, 8);
+            squeeze_any_position(backend, keccak_instance.sponge.state, owner->rounds, bytes_rate,
+                                 keccak_instance.sponge.byteIOIndex, owner->keccak_instance.delimitedSuffix, 0,
+                                 outputs[label], num_bytes);
+            continue;
+        }
+
+        if (num_batches)
+        {
+            memcpy(label_state, prepared_state, 200);
+            for (unsigned int idx = 0; idx < 8; idx++)
+                label_state[label_offset + idx] ^= label_bytes[idx];
+            squeeze_blocks(label_state, bytes_rate / 8, label_offset / 8 + 1, 0, outputs[label], num_batches);
+        }
+
+        uint64_t block = num_batches * parallelism;
+        for (size_t index = batch_bytes; index < num_bytes; index += bytes_rate, block++)
+        {
+            size_t bytes = num_bytes - index;
+            if (bytes > bytes_rate)
+                bytes = bytes_rate;
+
+            uint8_t index_bytes[8];
+            store64(index_bytes, block);
+            backend->overwrite_bytes(lanes.states, lanes.lane, prepared_state, 0, 200);
+            backend->add_bytes(lanes.states, lanes.lane, label_bytes, label_offset, 8);
+            backend->add_bytes(lanes.states, lanes.lane, index_bytes, label_offset + 8, 8);
+            next_lane(&lanes, outputs[label] + index, bytes);
+        }
+    }
+    flush_lanes(&lanes);
+
+    return 0;
+}
+
+/**
+ * Squeeze blocks at arbitrary indices, packed in the instances of the states so that every instance
+ * generates a requested block. The block index is added at any byte position, only blocks of which the
+ * padding does not fit after it take their own permutations.
+ */
+int VeXOF_SqueezeBlocks(VeXOF_Instance *vexof_instance, const uint64_t indices[], size_t num_blocks, uint8_t *data)
+{
+    if (!vexof_instance->squeezing)
+        check(prepare_squeeze(vexof_instance) == 0);
+
+    const KeccakWidth1600_SpongeInstance *sponge = &vexof_instance->keccak_instance.sponge;
+    const uint8_t *prepared_state =
+        vexof_instance->shared ? vexof_instance->shared->prepared_state : vexof_instance->prepared_state;
+    uint32_t bytes_rate = sponge->rate / 8;
+    unsigned int byte_io_index = sponge->byteIOIndex;
+    // The template is only padded if the block index is in a lane
+    int padded = counter_in_lane(byte_io_index, bytes_rate);
+    const uint8_t domain = vexof_instance->keccak_instance.delimitedSuffix;
+    const uint8_t last = 0x80;
+    Packed_Lanes lanes;
+
+    if (byte_io_index + 8 >= bytes_rate)
+    {
+        // The block index spills into a second block: the blocks still share the instances of the states
+        ALIGN(64)
+        uint8_t states[200 * VEXOF_MAX_PARALLELISM];
+        const VeXOF_Backend *backend = narrow_backend(get_backend(), num_blocks);
+        for (size_t idx = 0; idx < num_blocks; idx += backend->parallelism)
+        {
+            unsigned int num_lanes = num_blocks - idx < backend->parallelism ? (unsigned int)(num_blocks - idx)
+                                                                            : backend->parallelism;
+            permute_indices(backend, prepared_state, vexof_instance->rounds, bytes_rate, byte_io_index, domain,
+                            indices + idx, num_lanes, states);
+            for (unsigned int lane = 0; lane < num_lanes; lane++)
+                backend->extract_bytes(states, lane, data + (idx + lane) * bytes_rate, 0, bytes_rate);
+        }
+        return 0;
+    }
+
+    start_lanes(&lanes, vexof_instance->rounds);
+    for (size_t idx = 0; idx < num_blocks; idx++)
+    {
+        uint8_t index_bytes[8];
+        store64(index_bytes, indices[idx]);
+        lanes.backend->overwrite_bytes(lanes.states, lanes.lane, prepared_state, 0, 200);
+        lanes.backend->add_bytes(lanes.states, lanes.lane, index_bytes, byte_io_index, 8);
+        if (!padded)
+        {
+            lanes.backend->add_bytes(lanes.states, lanes.lane, &domain, byte_io_index + 8, 1);
+            lanes.backend->add_bytes(lanes.states, lanes.lane, &last, bytes_rate - 1, 1);
+        }
+        next_lane(&lanes, data + idx * bytes_rate, bytes_rate);
+    }
+    flush_lanes(&lanes);
+
+    return 0;
+}
+
+/**
+ * Generate XOF data from a seed.
+ */
+void vexof(const uint8_t *seed, size_t input_bytes, uint64_t *output, size_t output_bytes)
+{
+    if (output_bytes > 168)
+    {
+        VeXOF_Instance vexofInstance;
+        VeXOF_HashInitialize(&vexofInstance);
+        VeXOF_HashUpdate(&vexofInstance, seed, input_bytes);
+        VeXOF_Squeeze(&vexofInstance, output, output_bytes);
+    }
+    else if (input_bytes + 8 < 168)
+    {
+        // A single block: the seed, block index 0 and the padding, permuted once by the squeeze kernel,
+        // which skips the lanes past the rate in the last round. Index 0 adds nothing to the counter lane.
+        ALIGN(KeccakP1600_stateAlignment)
+        uint8_t state[KeccakP1600_stateSizeInBytes];
+        ALIGN(8)
+        uint8_t block[168];
+        KeccakP1600_Initialize(state);
+        KeccakP1600_AddBytes(state, seed, 0, (unsigned int)input_bytes);
+        KeccakP1600_AddByte(state, 0x1F, (unsigned int)input_bytes + 8);
+        KeccakP1600_AddByte(state, 0x80, 167);
+        KeccakP1600_SqueezeBlocks(state, (unsigned int)(output_bytes + 7) / 8, 0, 0, block, 1);
+        memcpy(output, block, output_bytes);
     }
     else
     {
         Keccak_HashInstance keccak_instance;
         Keccak_HashInitialize_SHAKE128(&keccak_instance);
         Keccak_HashUpdate(&keccak_instance, seed, 8 * input_bytes);
-        // Add the block index
-        keccak_instance.sponge.byteIOIndex += 8;
+        // Add the block index, LE64(0)
+        const uint8_t block[8] = {0};
+        Keccak_HashUpdate(&keccak_instance, block, 64);
         Keccak_HashFinal(&keccak_instance, NULL);
         Keccak_HashSqueeze(&keccak_instance, (uint8_t *)output, 8 * output_bytes);
     }
@@ -10,40 +10,126 @@
 #ifndef VEXOF_H
 #define VEXOF_H
 
+#include <string.h>
+#include <sys/uio.h>
+
 #include "FIPS202-timesx/KeccakHash.h"
 
-#ifndef PARALLELISM
 /**
- * Setting PARALLELISM to 8 will not always improve the performance on AVX512 architectures.
- * Whether is does depends on specifics of the application. Testing is advised.
+ * The number of parallel SHAKE instances of the widest implementation. The implementation itself is
+ * selected at runtime, see VeXOF_SetBackend.
  */
-#if __AVX512F__
-#define PARALLELISM 8
-#elif __AVX2__
-#define PARALLELISM 4
-#else
-#define PARALLELISM 1
+#define VEXOF_MAX_PARALLELISM 8
+
+#ifndef VEXOF_MAX_THREADS
+#define VEXOF_MAX_THREADS 64
+#endif
+
+#ifndef VEXOF_THREADS_MIN_BYTES
+/**
+ * Default size below which VeXOF_SqueezeParallel does not split the work over threads.
+ */
+#define VEXOF_THREADS_MIN_BYTES (1 << 20)
+#endif
+
+#ifndef VEXOF_STREAMING_MIN_BYTES
+/**
+ * Default size from which squeezes use non-temporal stores, if the size of the last level cache is unknown.
+ */
+#define VEXOF_STREAMING_MIN_BYTES (32 << 20)
 #endif
+
+#ifndef VEXOF_STREAM_CHUNK_BYTES
+/**
+ * Default and largest chunk of VeXOF_SqueezeStream, small enough to stay in the L1 or L2 cache.
+ */
+#define VEXOF_STREAM_CHUNK_BYTES (16 * 168 * VEXOF_MAX_PARALLELISM)
 #endif
 
-typedef struct
+#ifdef VEXOF_COMPACT
+/**
+ * Compact instances, well under 1 KB, only keep the block that is being read. The other blocks of a
+ * partial batch are discarded and generated again when needed.
+ */
+#define VEXOF_BUFFER_BYTES 168
+#else
+#define VEXOF_BUFFER_BYTES (168 * VEXOF_MAX_PARALLELISM)
+#endif
+
+struct VeXOF_Backend;
+
+typedef struct VeXOF_Instance
 {
-    Keccak_HashInstance keccak_instance;
-    uint8_t prepared_state[200 * PARALLELISM];
-    ALIGN(PARALLELISM * 8)
-    uint8_t states_data[200 * PARALLELISM];
+    // Squeezing: the padded state that is broadcast to the parallel instances, and the position
+    ALIGN(64)
+    uint8_t prepared_state[200];
+    // Forks: the instance whose absorbed state and template are used, or NULL
+    const struct VeXOF_Instance *shared;
+    const struct VeXOF_Backend *backend;
+    unsigned int rounds;
     int squeezing;
+    // Squeezing with VeXOF_SqueezeInterleaved, index is then a position in the interleaved order
+    int interleaved;
+    uint32_t buffer_pos;
+    uint32_t buffer_len;
     uint64_t block;
     uint64_t index;
+    // Generated output that has not been read yet
+    ALIGN(64)
+    uint8_t buffer[VEXOF_BUFFER_BYTES];
+    // Absorbing
+    Keccak_HashInstance keccak_instance;
 } VeXOF_Instance;
 
 /**
- * Function to initialize the VeXOF instance.
+ * Function to select the implementation used by the VeXOF instances that start squeezing hereafter.
+ * By default the fastest implementation supported by the CPU is selected on first use. The default
+ * can be overridden with the VEXOF_BACKEND environment variable; a name there that is unknown or not
+ * supported by the CPU is ignored and the default is used, VeXOF_GetBackend reports the outcome.
+ * Squeezes that need fewer blocks than the selected implementation generates at once use a narrower
+ * implementation automatically. The SIMD implementations are only available on x86-64.
+ * @param  name              "scalar", "times4-avx2", "times4-avx512", "times8-avx512" or NULL for the default.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL if unknown or not supported by the CPU.
+ */
+int VeXOF_SetBackend(const char *name);
+
+/**
+ * Function to get the name of the selected implementation.
+ * @return The name of the implementation, as accepted by VeXOF_SetBackend.
+ */
+const char *VeXOF_GetBackend(void);
+
+/**
+ * Function to initialize the VeXOF instance based on SHAKE128, with output blocks of 168 bytes.
  * @param  vexof_instance    Pointer to the VeXOF hash instance to be initialized.
  * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
  */
 int VeXOF_HashInitialize(VeXOF_Instance *vexof_instance);
 
+/**
+ * Function to initialize the VeXOF instance based on SHAKE256, with output blocks of 136 bytes.
+ * @param  vexof_instance    Pointer to the VeXOF hash instance to be initialized.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_HashInitialize_SHAKE256(VeXOF_Instance *vexof_instance);
+
+/**
+ * Function to initialize the VeXOF instance based on TurboSHAKE128, which uses the Keccak-p[1600]
+ * permutation reduced to 12 rounds. The output blocks are 168 bytes.
+ * @param  vexof_instance    Pointer to the VeXOF hash instance to be initialized.
+ * @param  domain            The TurboSHAKE domain separation byte, in the range 0x01 to 0x7F.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_HashInitialize_TurboSHAKE128(VeXOF_Instance *vexof_instance, uint8_t domain);
+
+/**
+ * Function to initialize the VeXOF instance based on TurboSHAKE256, with output blocks of 136 bytes.
+ * @param  vexof_instance    Pointer to the VeXOF hash instance to be initialized.
+ * @param  domain            The TurboSHAKE domain separation byte, in the range 0x01 to 0x7F.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_HashInitialize_TurboSHAKE256(VeXOF_Instance *vexof_instance, uint8_t domain);
+
 /**
  * Function to give input data to be absorbed. Can be called multiple times.
  * @param  vexof_instance    Pointer to the VeXOF instance.
@@ -57,11 +143,344 @@ int VeXOF_HashUpdate(VeXOF_Instance *vexof_instance, const uint8_t *data, size_t
  * Function to squeeze output data. Can be called multiple times.
  * @param  vexof_instance    Pointer to the VeXOF instance.
  * @param  data              Pointer to the buffer where to store the output data.
- * @param  num_bytes         The number of output bytes desired.
+ * @param  num_bytes         The number of output bytes desired, must be a multiple of 8.
  * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
  */
 int VeXOF_Squeeze(VeXOF_Instance *vexof_instance, uint64_t *data, size_t num_bytes);
 
+/**
+ * Function to squeeze any number of output bytes to a buffer of any alignment. Can be called multiple
+ * times and mixed with VeXOF_Squeeze: each call continues at the byte where the preceding one stopped.
+ * @param  vexof_instance    Pointer to the VeXOF instance.
+ * @param  data              Pointer to the buffer where to store the output data.
+ * @param  num_bytes         The number of output bytes desired.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_SqueezeBytes(VeXOF_Instance *vexof_instance, uint8_t *data, size_t num_bytes);
+
+/**
+ * Function to squeeze output data like VeXOF_SqueezeBytes, but refilling the buffer of the instance
+ * with a full batch of blocks whenever it runs empty. This is the slow path of VeXOF_Next64 and
+ * VeXOF_NextBytes.
+ * @param  vexof_instance    Pointer to the VeXOF instance.
+ * @param  data              Pointer to the buffer where to store the output data.
+ * @param  num_bytes         The number of output bytes desired.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_SqueezeBuffered(VeXOF_Instance *vexof_instance, uint8_t *data, size_t num_bytes);
+
+/**
+ * Function to get the next 8 output bytes as a word, for consumers that take the output a word at a
+ * time. Continues the same output stream as VeXOF_Squeeze and can be mixed with it. If squeezing fails,
+ * for instance on an instance squeezed with VeXOF_SqueezeInterleaved, 0 is returned and the position is
+ * unchanged; use VeXOF_NextBytes to detect failures.
+ * @param  vexof_instance    Pointer to the VeXOF instance.
+ * @return The next 8 bytes of the output stream, in the byte order of VeXOF_Squeeze.
+ */
+static inline uint64_t VeXOF_Next64(VeXOF_Instance *vexof_instance)
+{
+    uint64_t value = 0;
+
+    if (vexof_instance->buffer_len - vexof_instance->buffer_pos >= 8)
+    {
+        memcpy(&value, &vexof_instance->buffer[vexof_instance->buffer_pos], 8);
+        vexof_instance->buffer_pos += 8;
+        vexof_instance->index += 8;
+    }
+    else if (VeXOF_SqueezeBuffered(vexof_instance, (uint8_t *)&value, 8))
+        return 0;
+
+    return value;
+}
+
+/**
+ * Function to get the next few output bytes. Continues the same output stream as VeXOF_Squeeze and
+ * can be mixed with it.
+ * @param  vexof_instance    Pointer to the VeXOF instance.
+ * @param  data              Pointer to the buffer where to store the output data.
+ * @param  num_bytes         The number of output bytes desired.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+static inline int VeXOF_NextBytes(VeXOF_Instance *vexof_instance, uint8_t *data, size_t num_bytes)
+{
+    if (vexof_instance->buffer_len - vexof_instance->buffer_pos >= num_bytes)
+    {
+        memcpy(data, &vexof_instance->buffer[vexof_instance->buffer_pos], num_bytes);
+        vexof_instance->buffer_pos += num_bytes;
+        vexof_instance->index += num_bytes;
+        return 0;
+    }
+    return VeXOF_SqueezeBuffered(vexof_instance, data, num_bytes);
+}
+
+/**
+ * Function to squeeze output data into a list of buffers, filled one after the other as readv does. Full
+ * batches within a buffer are stored by the squeeze kernels, other blocks are extracted from the states
+ * into the buffers they belong to, so every output byte is stored once. Only the part of the last batch
+ * that is not read is kept in the instance for the next squeeze.
+ * @param  vexof_instance    Pointer to the VeXOF instance.
+ * @param  iov               Array of the buffers.
+ * @param  iov_count         The number of buffers.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_SqueezeScatter(VeXOF_Instance *vexof_instance, const struct iovec *iov, size_t iov_count);
+
+/**
+ * Function to squeeze output data into the tiles of a matrix stored row by row. Consecutive output fills
+ * the rows of a tile, then the next tile across, then the next row of tiles. Tile (i, j) starts at
+ * data + i * tile_rows * row_stride + j * tile_bytes. Like VeXOF_SqueezeScatter, every output byte is
+ * stored once. A column-major matrix that is filled row by row is a single row of tiles of one element:
+ * tile_bytes is the element size, tile_rows the number of columns, row_stride the distance between
+ * columns, and tiles_across the number of rows.
+ * @param  vexof_instance    Pointer to the VeXOF instance.
+ * @param  data              Pointer to the first tile.
+ * @param  row_stride        The distance in bytes between consecutive rows of the matrix, at least
+ *                           tiles_across * tile_bytes.
+ * @param  tile_bytes        The number of output bytes per row of a tile.
+ * @param  tile_rows         The number of rows of a tile.
+ * @param  tiles_across      The number of tiles in a row of tiles.
+ * @param  tiles_down        The number of rows of tiles.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_SqueezeTiles(VeXOF_Instance *vexof_instance, uint8_t *data, size_t row_stride, size_t tile_bytes,
+                       size_t tile_rows, size_t tiles_across, size_t tiles_down);
+
+/**
+ * Function to squeeze output data into rows, such as the padded rows of a matrix: a single tile of
+ * VeXOF_SqueezeTiles. Consecutive output fills row after row.
+ * @param  vexof_instance    Pointer to the VeXOF instance.
+ * @param  data              Pointer to the first row.
+ * @param  row_bytes         The number of output bytes per row.
+ * @param  row_stride        The distance in bytes between the starts of consecutive rows, at least row_bytes.
+ * @param  num_rows          The number of rows.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_SqueezeRows(VeXOF_Instance *vexof_instance, uint8_t *data, size_t row_bytes, size_t row_stride,
+                      size_t num_rows);
+
+/**
+ * Function to XOR output data into a buffer, as a keystream. The output is generated in chunks that stay
+ * in the cache, so the buffer is read and written once.
+ * @param  vexof_instance    Pointer to the VeXOF instance.
+ * @param  input             Pointer to the data to XOR the output with.
+ * @param  output            Pointer to the buffer where to store the result, which can be input itself
+ *                           but must not overlap it otherwise.
+ * @param  num_bytes         The number of bytes.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_SqueezeXor(VeXOF_Instance *vexof_instance, const uint8_t *input, uint8_t *output, size_t num_bytes);
+
+/**
+ * Version and group size of the interleaved order of VeXOF_SqueezeInterleaved. The output is made of
+ * groups of VEXOF_INTERLEAVED_BLOCKS consecutive blocks, stored lane by lane: lane x of block
+ * VEXOF_INTERLEAVED_BLOCKS * g + i at byte 8 * (VEXOF_INTERLEAVED_BLOCKS * (g * lanes_per_block + x) + i).
+ * The order is the same for all backends.
+ */
+#define VEXOF_INTERLEAVED_VERSION 1
+#define VEXOF_INTERLEAVED_BLOCKS 8
+
+/**
+ * Function to squeeze output data in interleaved order, for consumers that only need reproducible uniform
+ * bytes. The bytes are those of VeXOF_Squeeze at the same position of the group, in a different order, so
+ * the SIMD backends store their states without transposing them. The position in the output stream is
+ * kept in the instance. It can only start at the beginning of the output, and an instance squeezed this
+ * way fails with the other functions that continue the output stream and with VeXOF_Export; VeXOF_SqueezeAt,
+ * VeXOF_SqueezeBytesAt and VeXOF_SqueezeBlocks, which do not use the position, can still be used.
+ * @param  vexof_instance    Pointer to the VeXOF instance.
+ * @param  version           The version of the order, VEXOF_INTERLEAVED_VERSION.
+ * @param  data              Pointer to the buffer where to store the output data.
+ * @param  num_bytes         The number of output bytes desired.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_SqueezeInterleaved(VeXOF_Instance *vexof_instance, unsigned int version, uint8_t *data, size_t num_bytes);
+
+/**
+ * Consumer of the output of VeXOF_SqueezeStream.
+ * @param  context           The context passed to VeXOF_SqueezeStream.
+ * @param  data              Pointer to the next chunk of output, valid until the consumer returns.
+ * @param  num_bytes         The number of bytes in the chunk.
+ * @return 0 to continue, any other value to stop VeXOF_SqueezeStream, which returns it.
+ */
+typedef int (*VeXOF_Consumer)(void *context, const uint8_t *data, size_t num_bytes);
+
+/**
+ * Function to squeeze output data in chunks that are passed to a consumer, so that large outputs are
+ * processed while they are in the cache and never stored as a whole. The chunks are consecutive output
+ * of the instance, as if squeezed with VeXOF_SqueezeBytes.
+ * @param  vexof_instance    Pointer to the VeXOF instance.
+ * @param  num_bytes         The total number of output bytes desired.
+ * @param  chunk_bytes       The number of bytes per chunk, at most VEXOF_STREAM_CHUNK_BYTES, or 0 for
+ *                           VEXOF_STREAM_CHUNK_BYTES. The last chunk can be shorter.
+ * @param  consumer          The function that is called with each chunk.
+ * @param  context           Pointer passed to the consumer.
+ * @return KECCAK_SUCCESS if successful, otherwise KECCAK_FAIL or the value returned by the consumer.
+ */
+int VeXOF_SqueezeStream(VeXOF_Instance *vexof_instance, size_t num_bytes, size_t chunk_bytes,
+                        VeXOF_Consumer consumer, void *context);
+
+/**
+ * Function to copy an instance. Unlike copying the whole structure, only the absorbed state, the
+ * template and the output that has not been read yet are copied.
+ * @param  clone             Pointer to the VeXOF instance to be initialized as a copy.
+ * @param  vexof_instance    Pointer to the VeXOF instance to copy.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_Clone(VeXOF_Instance *clone, const VeXOF_Instance *vexof_instance);
+
+/**
+ * Function to branch from an instance without copying its state. The fork refers to the absorbed
+ * state and the template of parent, and copies them only when it absorbs more. Forks continue at the
+ * position of a squeezing parent, or absorb after the input of an absorbing parent. A fork of a parent
+ * that is squeezing copies the unread rest of the block being read, at most one block, and runs no
+ * permutation. The parent must not absorb, be reinitialized or go out of scope while forks refer to it.
+ * @param  fork              Pointer to the VeXOF instance to be initialized as a fork.
+ * @param  parent            Pointer to the VeXOF instance to branch from.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_Fork(VeXOF_Instance *fork, const VeXOF_Instance *parent);
+
+/**
+ * Size and version of the format of VeXOF_Export. All integers in it are little endian, so that
+ * exported instances can be stored and shared between platforms.
+ */
+#define VEXOF_EXPORT_BYTES 224
+#define VEXOF_EXPORT_VERSION 1
+
+/**
+ * Function to export an instance, to restore it later with VeXOF_Import instead of absorbing the same
+ * input again. Both absorbing and squeezing instances can be exported; the latter include their
+ * position in the output stream.
+ * @param  vexof_instance    Pointer to the VeXOF instance.
+ * @param  data              Pointer to the buffer of VEXOF_EXPORT_BYTES bytes where to store the instance.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_Export(const VeXOF_Instance *vexof_instance, uint8_t data[VEXOF_EXPORT_BYTES]);
+
+/**
+ * Function to restore an instance exported by VeXOF_Export. Absorbing and squeezing continue where
+ * they were when the instance was exported.
+ * @param  vexof_instance    Pointer to the VeXOF instance to be initialized.
+ * @param  data              Pointer to the VEXOF_EXPORT_BYTES bytes of the exported instance.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL if the data is not a valid exported instance.
+ */
+int VeXOF_Import(VeXOF_Instance *vexof_instance, const uint8_t data[VEXOF_EXPORT_BYTES]);
+
+/**
+ * Function to squeeze output data at an arbitrary position of the output stream. Only the blocks
+ * covering the requested range are computed and the position of VeXOF_Squeeze is not affected.
+ * @param  vexof_instance    Pointer to the VeXOF instance.
+ * @param  offset            Position in the output stream in bytes, must be a multiple of 8.
+ * @param  data              Pointer to the buffer where to store the output data.
+ * @param  num_bytes         The number of output bytes desired.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_SqueezeAt(VeXOF_Instance *vexof_instance, uint64_t offset, uint64_t *data, size_t num_bytes);
+
+/**
+ * Function to squeeze output data at any byte position of the output stream, for instance one row of
+ * an expanded matrix. Like VeXOF_SqueezeAt, but with any offset, length and buffer alignment.
+ * @param  vexof_instance    Pointer to the VeXOF instance.
+ * @param  offset            Position in the output stream in bytes.
+ * @param  data              Pointer to the buffer where to store the output data.
+ * @param  num_bytes         The number of output bytes desired.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_SqueezeBytesAt(VeXOF_Instance *vexof_instance, uint64_t offset, uint8_t *data, size_t num_bytes);
+
+/**
+ * Function to squeeze whole output blocks at arbitrary indices, such as a random subset of the rows
+ * of an expanded matrix. The blocks are generated together whatever the distance between their
+ * indices, and the position of VeXOF_Squeeze is not affected. Only if the input ends in the last 8 bytes
+ * of a block, so that the padding follows the block index in the next block, does each block take its
+ * own permutations.
+ * @param  vexof_instance    Pointer to the VeXOF instance.
+ * @param  indices           Array of the block indices.
+ * @param  num_blocks        The number of blocks.
+ * @param  data              Pointer to the buffer where to store the blocks, one rate (168 bytes for
+ *                           SHAKE128) per block in the order of indices.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_SqueezeBlocks(VeXOF_Instance *vexof_instance, const uint64_t indices[], size_t num_blocks, uint8_t *data);
+
+/**
+ * Function to configure the worker threads of VeXOF_SqueezeParallel. The threads are created once
+ * and reused by subsequent calls. By default one thread per online CPU is used. If the threads cannot
+ * be created, VeXOF_SqueezeParallel uses the calling thread only.
+ * @param  num_threads       The number of threads, including the calling thread, at most VEXOF_MAX_THREADS.
+ * @param  min_bytes         Squeezes of fewer bytes are performed by the calling thread only.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL if the threads could not be created.
+ */
+int VeXOF_SetThreads(unsigned int num_threads, size_t min_bytes);
+
+/**
+ * Function to configure non-temporal stores. Squeezes of at least min_bytes bytes write their output
+ * with stores that bypass the caches, so that output that does not fit in the cache does not evict the
+ * data of the application, and is not read from memory before it is overwritten. By default this is
+ * done for squeezes larger than the last level cache.
+ * @param  min_bytes         Squeezes of fewer bytes are written through the caches. 0 restores the
+ *                           default, 1 streams every squeeze and SIZE_MAX none.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_SetStreaming(size_t min_bytes);
+
+/**
+ * Function to squeeze output data using multiple threads. Can be mixed with VeXOF_Squeeze. The threads
+ * are shared by all instances: parallel squeezes from independent threads, and VeXOF_SetThreads, wait
+ * for each other and run one at a time.
+ * @param  vexof_instance    Pointer to the VeXOF instance.
+ * @param  data              Pointer to the buffer where to store the output data.
+ * @param  num_bytes         The number of output bytes desired.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_SqueezeParallel(VeXOF_Instance *vexof_instance, uint64_t *data, size_t num_bytes);
+
+/**
+ * Function to generate XOF data for many seeds at once. The blocks of all outputs are distributed
+ * over the parallel instances, so that short outputs of different seeds share permutations.
+ * @param  seeds             Array of pointers to the seeds.
+ * @param  seed_lens         Array of seed lengths in bytes.
+ * @param  outputs           Array of pointers to the buffers where to store the output data.
+ * @param  out_lens          Array of the number of output bytes desired for each seed.
+ * @param  num_seeds         The number of seeds.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_BatchSqueeze(const uint8_t *const seeds[], const size_t seed_lens[], uint8_t *const outputs[],
+                       const size_t out_lens[], size_t num_seeds);
+
+/**
+ * Function to generate XOF data for many seeds that start with the same input, absorbed once in an
+ * instance. The output for a suffix equals that of the instance after absorbing the suffix. Short
+ * suffixes are added to the absorbed state without a permutation, and the blocks of all outputs are
+ * distributed over the parallel instances. The instance is not modified.
+ * @param  vexof_instance    Pointer to the VeXOF instance that absorbed the common input.
+ * @param  suffixes          Array of pointers to the suffixes.
+ * @param  suffix_lens       Array of suffix lengths in bytes.
+ * @param  outputs           Array of pointers to the buffers where to store the output data.
+ * @param  out_lens          Array of the number of output bytes desired for each suffix.
+ * @param  num_suffixes      The number of suffixes.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_BatchSqueezeSuffixes(const VeXOF_Instance *vexof_instance, const uint8_t *const suffixes[],
+                               const size_t suffix_lens[], uint8_t *const outputs[], const size_t out_lens[],
+                               size_t num_suffixes);
+
+/**
+ * Function to generate labelled substreams of an absorbing instance, such as the rows of a matrix
+ * expanded from one seed. The substream of a label is the output of the instance after absorbing the
+ * label as 8 little endian bytes, but the input is not absorbed again for every label. Short
+ * substreams of different labels share permutations, except when the common input ends in the last
+ * 16 bytes of a block: the label and the padding then take a permutation per label. The instance is
+ * not modified.
+ * @param  vexof_instance    Pointer to the VeXOF instance that absorbed the common input.
+ * @param  labels            Array of the labels.
+ * @param  outputs           Array of pointers to the buffers where to store the substreams.
+ * @param  num_bytes         The number of output bytes desired for each label.
+ * @param  num_labels        The number of labels.
+ * @return KECCAK_SUCCESS if successful, KECCAK_FAIL otherwise.
+ */
+int VeXOF_SqueezeLabels(const VeXOF_Instance *vexof_instance, const uint64_t labels[], uint8_t *const outputs[],
+                        size_t num_bytes, size_t num_labels);
+
 /**
  * Function to generate XOF data from a seed.
  * @param  seed              Pointer to the seed data.